@@ -1,2 +1,104 @@
+from esphome import pins
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.const import CONF_CLK_PIN, CONF_DATA_RATE, CONF_ID, CONF_MOSI_PIN, CONF_PLATFORM
+from esphome.core import CORE
+import esphome.final_validate as fv
+
 CODEOWNERS = ["@semvis123"]
 DEPENDENCIES = ["spi"]
+AUTO_LOAD = ["sensor"]
+MULTI_CONF = True
+
+CONF_TRANSPORT = "transport"
+CONF_BUS_ID = "bus_id"
+
+DEFAULT_TRANSPORT = "software"
+DEFAULT_DATA_RATE = 20e6
+
+crowpanel_epaper_ns = cg.esphome_ns.namespace("crowpanel_epaper")
+CrowPanelTransport = crowpanel_epaper_ns.class_("CrowPanelTransport")
+SoftSPITransport = crowpanel_epaper_ns.class_("SoftSPITransport", CrowPanelTransport)
+ESP32SPITransport = crowpanel_epaper_ns.class_("ESP32SPITransport", CrowPanelTransport)
+CrowPanelBus = crowpanel_epaper_ns.class_("CrowPanelBus", cg.Component)
+
+TRANSPORTS = {
+    "software": SoftSPITransport,
+    "hardware": ESP32SPITransport,
+}
+
+# How CLK/MOSI are driven, for a display of its own or for a bus shared by several.
+TRANSPORT_SCHEMA = {
+    cv.Optional(CONF_CLK_PIN): pins.internal_gpio_output_pin_schema,
+    cv.Optional(CONF_MOSI_PIN): pins.internal_gpio_output_pin_schema,
+    cv.Optional(CONF_TRANSPORT): cv.one_of(*TRANSPORTS, lower=True),
+    # The SSD1683 is specified up to 20MHz for writes.
+    cv.Optional(CONF_DATA_RATE): cv.All(cv.frequency, cv.Range(min=100e3, max=20e6)),
+}
+
+
+def validate_transport(config):
+    if CONF_BUS_ID in config:
+        for key in (CONF_CLK_PIN, CONF_MOSI_PIN, CONF_TRANSPORT, CONF_DATA_RATE):
+            if key in config:
+                raise cv.Invalid(f"{key} is set on the bus given by {CONF_BUS_ID}")
+        return config
+    for key in (CONF_CLK_PIN, CONF_MOSI_PIN):
+        if key not in config:
+            raise cv.Invalid(f"{key} is required")
+    if config.get(CONF_TRANSPORT) == "hardware" and not CORE.is_esp32:
+        raise cv.Invalid("The hardware transport is only available on ESP32")
+    return config
+
+
+def _uses_hardware_transport(config):
+    return CONF_BUS_ID not in config and config.get(CONF_TRANSPORT) == "hardware"
+
+
+def final_validate_transport(config):
+    # The hardware transport always takes SPI2, a second one would fail to initialize it.
+    # Displays that need it too have to share it through a bus.
+    if not _uses_hardware_transport(config):
+        return config
+    full_config = fv.full_config.get()
+    users = [c for c in full_config.get("crowpanel_epaper", []) if _uses_hardware_transport(c)]
+    users += [
+        c
+        for c in full_config.get("display", [])
+        if c.get(CONF_PLATFORM) == "crowpanel_epaper" and _uses_hardware_transport(c)
+    ]
+    if users and users[0][CONF_ID].id != config[CONF_ID].id:
+        raise cv.Invalid(
+            f"Only one hardware transport is supported, '{users[0][CONF_ID].id}' already uses it. "
+            f"Share it with a crowpanel_epaper bus and {CONF_BUS_ID}"
+        )
+    return config
+
+
+async def new_transport(config):
+    clk_pin_expr = await cg.gpio_pin_expression(config[CONF_CLK_PIN])
+    mosi_pin_expr = await cg.gpio_pin_expression(config[CONF_MOSI_PIN])
+    if config.get(CONF_TRANSPORT, DEFAULT_TRANSPORT) == "hardware":
+        data_rate = config.get(CONF_DATA_RATE, DEFAULT_DATA_RATE)
+        return ESP32SPITransport.new(clk_pin_expr, mosi_pin_expr, int(data_rate))
+    return SoftSPITransport.new(clk_pin_expr, mosi_pin_expr)
+
+
+# A bus shared by several displays, each with its own CS, DC and BUSY pins.
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(CrowPanelBus),
+            **TRANSPORT_SCHEMA,
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    validate_transport,
+)
+
+FINAL_VALIDATE_SCHEMA = final_validate_transport
+
+
+async def to_code(config):
+    transport = await new_transport(config)
+    var = cg.new_Pvariable(config[CONF_ID], transport)
+    await cg.register_component(var, config)
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "crowpanel_epaper.h"
+
+namespace esphome {
+namespace crowpanel_epaper {
+
+// Drops a page's cached frame, or every page's when no page is given.
+template<typename... Ts> class InvalidatePageCacheAction : public Action<Ts...>, public Parented<CrowPanelEPaperBase> {
+ public:
+  TEMPLATABLE_VALUE(display::DisplayPage *, page)
+
+  void play(Ts... x) override {
+    this->parent_->invalidate_page_cache(this->page_.has_value() ? this->page_.value(x...) : nullptr);
+  }
+};
+
+// Asks for an update, merged with any other pending request.
+template<typename... Ts> class RequestUpdateAction : public Action<Ts...>, public Parented<CrowPanelEPaperBase> {
+ public:
+  void set_priority(UpdatePriority priority) { this->priority_ = priority; }
+  void set_mode(UpdateMode mode) {
+    this->mode_ = mode;
+    this->has_mode_ = true;
+  }
+
+  void play(Ts... x) override {
+    if (this->has_mode_) {
+      this->parent_->request_update(this->priority_, this->mode_);
+    } else {
+      this->parent_->request_update(this->priority_);
+    }
+  }
+
+ protected:
+  UpdatePriority priority_{UpdatePriority::ROUTINE};
+  bool has_mode_{false};
+  UpdateMode mode_{UpdateMode::FULL};
+};
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
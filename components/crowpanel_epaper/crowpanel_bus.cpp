@@ -0,0 +1,46 @@
+#include "crowpanel_bus.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace crowpanel_epaper {
+
+static const char *const TAG = "crowpanel_epaper.bus";
+
+void CrowPanelBus::setup() {
+  if (!this->transport_->setup()) {
+    ESP_LOGE(TAG, "Transport setup failed");
+    this->mark_failed();
+  }
+}
+
+void CrowPanelBus::loop() {
+  // A new round: the next panel in line gets a slice.
+  this->slice_given_ = false;
+}
+
+void CrowPanelBus::dump_config() {
+  ESP_LOGCONFIG(TAG, "CrowPanel E-Paper Bus:");
+  this->transport_->dump_config();
+}
+
+bool CrowPanelBus::claim_slice(CrowPanelEPaperBase *panel) {
+  if (std::find(this->queue_.begin(), this->queue_.end(), panel) == this->queue_.end())
+    this->queue_.push_back(panel);
+  if (this->slice_given_ || this->queue_.front() != panel)
+    return false;
+  this->slice_given_ = true;
+  return true;
+}
+
+void CrowPanelBus::end_slice(CrowPanelEPaperBase *panel, bool more) {
+  auto it = std::find(this->queue_.begin(), this->queue_.end(), panel);
+  if (it != this->queue_.end())
+    this->queue_.erase(it);
+  if (more)
+    this->queue_.push_back(panel);
+}
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
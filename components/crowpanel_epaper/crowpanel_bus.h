@@ -0,0 +1,45 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "crowpanel_transport.h"
+
+#include <vector>
+
+namespace esphome {
+namespace crowpanel_epaper {
+
+class CrowPanelEPaperBase;
+
+// Several panels on one CLK/MOSI pair, each with its own CS, D/C and BUSY lines.
+//
+// Commands go out whenever a panel runs, every command transaction ends within the loop() call
+// that started it. Frame uploads span many loop() calls, so on a shared bus they are cut into
+// slices that end with CS high. The bus hands out one slice per loop() round, in the order
+// panels asked for them: uploads interleave, and a panel waiting for its refresh waveform
+// doesn't hold the others up.
+class CrowPanelBus : public Component {
+ public:
+  explicit CrowPanelBus(CrowPanelTransport *transport) : transport_(transport) {}
+
+  CrowPanelTransport *get_transport() { return this->transport_; }
+
+  float get_setup_priority() const override { return setup_priority::BUS; }
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  // Asks for the next upload slice. Returns true if `panel` may send one now; otherwise it keeps
+  // its place in the queue and asks again on its next loop().
+  bool claim_slice(CrowPanelEPaperBase *panel);
+  // Called after the slice, with CS high again. With `more` the panel queues up for another one.
+  void end_slice(CrowPanelEPaperBase *panel, bool more);
+
+ protected:
+  CrowPanelTransport *transport_;
+  // Panels waiting for a slice, the front one is next.
+  std::vector<CrowPanelEPaperBase *> queue_;
+  bool slice_given_{false};
+};
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
@@ -3,11 +3,18 @@
 #include "esphome/core/application.h"
 #include "esphome/core/helpers.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
 namespace esphome {
 namespace crowpanel_epaper {
 
 static const char *const TAG = "crowpanel_epaper";
 
+// Smallest chunk update_send_data_ sends, so a slow first measurement can't stall the upload.
+static const size_t MIN_SEND_CHUNK = 32;
+
 // SSD1683 EPD Driver chip command definitions
 static const uint8_t CMD_SOFT_RESET = 0x12;
 static const uint8_t CMD_DISPLAY_UPDATE_CONTROL = 0x21;
@@ -16,12 +23,19 @@ static const uint8_t CMD_DEEP_SLEEP = 0x10;
 static const uint8_t CMD_DATA_ENTRY_MODE = 0x11;
 static const uint8_t CMD_BORDER_WAVEFORM = 0x3C;
 static const uint8_t CMD_WRITE_RAM = 0x24;
+static const uint8_t CMD_WRITE_OLD_RAM = 0x26;
 static const uint8_t CMD_UPDATE_SEQUENCE = 0x22;
 static const uint8_t CMD_SET_X_ADDR = 0x44;
 static const uint8_t CMD_SET_Y_ADDR = 0x45;
 static const uint8_t CMD_SET_X_COUNTER = 0x4E;
 static const uint8_t CMD_SET_Y_COUNTER = 0x4F;
 static const uint8_t CMD_SET_MUX = 0x01;
+static const uint8_t CMD_WRITE_TEMPERATURE = 0x1A;
+static const uint8_t CMD_WRITE_LUT = 0x32;
+static const uint8_t CMD_END_OPTION = 0x3F;
+static const uint8_t CMD_GATE_VOLTAGE = 0x03;
+static const uint8_t CMD_SOURCE_VOLTAGE = 0x04;
+static const uint8_t CMD_WRITE_VCOM = 0x2C;
 
 // Explicit target selection when the SSD1683 is used in cascade mode.
 static const uint8_t CMD_TARGET_PRIMARY = 0x00;
@@ -32,156 +46,296 @@ static const uint8_t PARAM_BORDER_FULL = 0x05;
 static const uint8_t PARAM_BORDER_PARTIAL = 0x80;
 static const uint8_t PARAM_FULL_UPDATE = 0xF7;
 static const uint8_t PARAM_PARTIAL_UPDATE = 0xFF;
+static const uint8_t PARAM_LOAD_LUT = 0x91;    // Load the waveform for the temperature register, no display
+static const uint8_t PARAM_FAST_UPDATE = 0xC7; // Display mode 1 with the waveform already loaded
 static const uint8_t PARAM_DEEP_SLEEP_MODE = 0x01;
 static const uint8_t PARAM_X_INC_Y_INC = 0x03; // left-right, top-down
 static const uint8_t PARAM_X_DEC_Y_INC = 0x02; // right-left, top-down
 static const uint8_t PARAM_SEL_SINGLE_CHIP = 0x00;
 static const uint8_t PARAM_SEL_CASCADE = 0x10;
 
-// SSD1683 EPD Driver chip command sequences
-// Format: command, num_args, arg1, arg2...
-// Special case: if num_args has bit 7 set (0x80), it indicates a delay command
-// End marker is two 0xFF bytes
-
-const uint8_t display_start_sequence[] = {
-  CMD_SOFT_RESET,                                                // Soft reset
-  CMD_SET_MUX, 0x03, 0x2b, 0x01, 0x00,                           // Set MUX as 300
-  CMD_DISPLAY_UPDATE_CONTROL, 0x02, 0x40, PARAM_SEL_SINGLE_CHIP, // Display update control
-  CMD_BORDER_WAVEFORM, 0x01, PARAM_BORDER_FULL,                  // Border waveform for full refresh
-  CMD_DATA_ENTRY_MODE, 0x01, PARAM_X_INC_Y_INC,                  // Data entry mode (X+ Y+)
-  CMD_SET_X_ADDR, 0x02, 0x00, 0x31,                              // Set RAM X Address Start/End Pos (0 to 49 -> 400 pixels)
-  CMD_SET_Y_ADDR, 0x04, 0x00, 0x00, 0x2b, 0x01,                  // Set RAM Y Address Start/End Pos (0 to 299 -> 300 pixels)
-  CMD_SET_X_COUNTER, 0x01, 0x00,                                 // Set RAM X Address counter
-  CMD_SET_Y_COUNTER, 0x02, 0x00, 0x00,                           // Set RAM Y Address counter
-  COMMAND_END_MARKER, COMMAND_END_MARKER                         // End marker
-};
-
-const uint8_t display_start_sequence_5p79in[] = {
-  CMD_SOFT_RESET, DELAY_FLAG, 10,                        // Soft reset and 10ms delay
+// SSD1683 EPD Driver chip command sequences, see crowpanel_sequence.h for the format.
+// The state machine runs the waits, loop() is never blocked.
+
+// Register setup, lost in a reset. Also sent when waking up from deep sleep.
+static constexpr auto display_registers = sequence_part(
+  cmd(CMD_SET_MUX, 0x2b, 0x01, 0x00),                               // Set MUX as 300
+  cmd(CMD_DISPLAY_UPDATE_CONTROL, 0x40, PARAM_SEL_SINGLE_CHIP),    // Display update control
+  cmd(CMD_BORDER_WAVEFORM, PARAM_BORDER_FULL),                      // Border waveform for full refresh
+  cmd(CMD_DATA_ENTRY_MODE, PARAM_X_INC_Y_INC),                      // Data entry mode (X+ Y+)
+  cmd(CMD_SET_X_ADDR, 0x00, 0x31),                                  // Set RAM X Address Start/End Pos (0 to 49 -> 400 pixels)
+  cmd(CMD_SET_Y_ADDR, 0x00, 0x00, 0x2b, 0x01),                      // Set RAM Y Address Start/End Pos (0 to 299 -> 300 pixels)
+  cmd(CMD_SET_X_COUNTER, 0x00),                                     // Set RAM X Address counter
+  cmd(CMD_SET_Y_COUNTER, 0x00, 0x00)                                // Set RAM Y Address counter
+);
+static constexpr auto display_start_sequence = make_sequence(
+  cmd_wait_busy(CMD_SOFT_RESET),                                    // Soft reset, wait until it's done
+  display_registers
+);
+static constexpr auto display_wake_sequence = make_sequence(display_registers);
+
+static constexpr auto display_registers_5p79in = sequence_part(
   // Do not set MUX. Not sure why, but it causes issues with the 5.79in display.
   // Set up the RAM area for the primary controller
-  CMD_DATA_ENTRY_MODE | CMD_TARGET_PRIMARY, 0x01, PARAM_X_INC_Y_INC, // This panel goes from left to right.
-  CMD_SET_X_ADDR | CMD_TARGET_PRIMARY, 0x02, 0x00, 0x31,             // Set RAM X Address Start/End Pos (0 to 49 -> 400 pixels)
-  CMD_SET_Y_ADDR | CMD_TARGET_PRIMARY, 0x04, 0x00, 0x00, 0x0f, 0x01, // Set RAM Y Address Start/End Pos (0 to 271 -> 272 pixels)
+  cmd(CMD_DATA_ENTRY_MODE | CMD_TARGET_PRIMARY, PARAM_X_INC_Y_INC),         // This panel goes from left to right.
+  cmd(CMD_SET_X_ADDR | CMD_TARGET_PRIMARY, 0x00, 0x31),                     // Set RAM X Address Start/End Pos (0 to 49 -> 400 pixels)
+  cmd(CMD_SET_Y_ADDR | CMD_TARGET_PRIMARY, 0x00, 0x00, 0x0f, 0x01),         // Set RAM Y Address Start/End Pos (0 to 271 -> 272 pixels)
   // Set up the RAM area for the secondary controller
-  CMD_DATA_ENTRY_MODE | CMD_TARGET_SECONDARY, 0x01, PARAM_X_DEC_Y_INC, // This panel goes from right to left.
-  CMD_SET_X_ADDR | CMD_TARGET_SECONDARY, 0x02, 0x31, 0x00,             // Set RAM X Address Start/End Pos (49 to 0 -> 400 pixels)
-  CMD_SET_Y_ADDR | CMD_TARGET_SECONDARY, 0x04, 0x00, 0x00, 0x0f, 0x01, // Set RAM Y Address Start/End Pos (0 to 271 -> 272 pixels)
-  COMMAND_END_MARKER, COMMAND_END_MARKER                 // End marker
+  cmd(CMD_DATA_ENTRY_MODE | CMD_TARGET_SECONDARY, PARAM_X_DEC_Y_INC),       // This panel goes from right to left.
+  cmd(CMD_SET_X_ADDR | CMD_TARGET_SECONDARY, 0x31, 0x00),                   // Set RAM X Address Start/End Pos (49 to 0 -> 400 pixels)
+  cmd(CMD_SET_Y_ADDR | CMD_TARGET_SECONDARY, 0x00, 0x00, 0x0f, 0x01)        // Set RAM Y Address Start/End Pos (0 to 271 -> 272 pixels)
+);
+static constexpr auto display_start_sequence_5p79in = make_sequence(
+  cmd_delay(CMD_SOFT_RESET, 10),                                    // Soft reset and 10ms delay
+  display_registers_5p79in
+);
+static constexpr auto display_wake_sequence_5p79in = make_sequence(display_registers_5p79in);
+
+static constexpr auto display_stop_sequence = make_sequence(
+  cmd(CMD_DEEP_SLEEP, PARAM_DEEP_SLEEP_MODE)                        // Deep sleep mode
+);
+
+static constexpr auto full_refresh_sequence = make_sequence(
+  cmd(CMD_UPDATE_SEQUENCE, PARAM_FULL_UPDATE),                      // Display update sequence option (full)
+  cmd_delay(CMD_DISPLAY_UPDATE, 10)                                 // Master activation with 10ms delay
+);
+
+static constexpr auto fast_refresh_entries = sequence_part(
+  cmd(CMD_UPDATE_SEQUENCE, PARAM_FAST_UPDATE),                      // Display update sequence option (no LUT reload)
+  cmd_delay(CMD_DISPLAY_UPDATE, 10)                                 // Master activation with 10ms delay
+);
+static constexpr auto fast_refresh_sequence = make_sequence(fast_refresh_entries);
+
+// Without a custom LUT, FAST makes the controller load its OTP waveform for a higher temperature
+// than the real one (those waveforms are shorter), then refreshes without reloading it.
+static constexpr auto fast_otp_refresh_entries = sequence_part(
+  cmd(CMD_UPDATE_SEQUENCE, PARAM_LOAD_LUT),
+  cmd_wait_busy(CMD_DISPLAY_UPDATE),                                // Loading the LUT takes a moment
+  fast_refresh_entries
+);
+static constexpr auto fast_otp_sequence(uint8_t temperature) {
+  return make_sequence(cmd(CMD_WRITE_TEMPERATURE, temperature, 0x00), fast_otp_refresh_entries);
+}
+// A cascade's secondary controller needs the temperature as well.
+static constexpr auto fast_otp_sequence_cascade(uint8_t temperature) {
+  return make_sequence(cmd(CMD_WRITE_TEMPERATURE, temperature, 0x00),
+                       cmd(CMD_WRITE_TEMPERATURE | CMD_TARGET_SECONDARY, temperature, 0x00), fast_otp_refresh_entries);
+}
+static constexpr uint8_t FAST_TEMPERATURE_COLD = 90;
+static constexpr uint8_t FAST_TEMPERATURE_WARM = 110;
+static constexpr auto fast_otp_sequence_cold = fast_otp_sequence(FAST_TEMPERATURE_COLD);
+static constexpr auto fast_otp_sequence_warm = fast_otp_sequence(FAST_TEMPERATURE_WARM);
+static constexpr auto fast_otp_sequence_cascade_cold = fast_otp_sequence_cascade(FAST_TEMPERATURE_COLD);
+static constexpr auto fast_otp_sequence_cascade_warm = fast_otp_sequence_cascade(FAST_TEMPERATURE_WARM);
+
+static constexpr auto partial_refresh_sequence = make_sequence(
+  cmd(CMD_UPDATE_SEQUENCE, PARAM_PARTIAL_UPDATE),                   // Display update sequence option (partial)
+  cmd_delay(CMD_DISPLAY_UPDATE, 10)                                 // Master activation with 10ms delay
+);
+
+static const char *const PHASE_NAMES[UPDATE_PHASE_COUNT] = {
+    "Render", "Wake", "Wait Busy", "Prepare", "Send", "Refresh", "Longest loop()",
 };
 
-const uint8_t display_stop_sequence[] = {
-  CMD_DEEP_SLEEP, 0x01, PARAM_DEEP_SLEEP_MODE,       // Deep sleep mode
-  COMMAND_END_MARKER, COMMAND_END_MARKER             // End marker
-};
+static const char *update_mode_to_string(UpdateMode mode) {
+  switch (mode) {
+    case UpdateMode::FULL:
+      return "FULL";
+    case UpdateMode::PARTIAL:
+      return "PARTIAL";
+    case UpdateMode::FAST:
+      return "FAST";
+    default:
+      return "UNKNOWN";
+  }
+}
 
-const uint8_t full_refresh_sequence[] = {
-  CMD_UPDATE_SEQUENCE, 0x01, PARAM_FULL_UPDATE,      // Display update sequence option (full)
-  CMD_DISPLAY_UPDATE, DELAY_FLAG, 10,                // Master activation with 10ms delay
-  COMMAND_END_MARKER, COMMAND_END_MARKER             // End marker
-};
+// ========================================================
+// PhaseStats Implementation
+// ========================================================
 
-const uint8_t partial_refresh_sequence[] = {
-  CMD_UPDATE_SEQUENCE, 0x01, PARAM_PARTIAL_UPDATE,   // Display update sequence option (partial)
-  CMD_DISPLAY_UPDATE, DELAY_FLAG, 10,                // Master activation with 10ms delay
-  COMMAND_END_MARKER, COMMAND_END_MARKER             // End marker
-};
+void PhaseStats::add(uint32_t sample) {
+  this->samples_[this->next_] = sample;
+  this->next_ = (this->next_ + 1) % SIZE;
+  if (this->count_ < SIZE)
+    this->count_++;
+}
+
+uint32_t PhaseStats::min() const {
+  if (this->count_ == 0)
+    return 0;
+  return *std::min_element(this->samples_, this->samples_ + this->count_);
+}
+
+uint32_t PhaseStats::max() const {
+  if (this->count_ == 0)
+    return 0;
+  return *std::max_element(this->samples_, this->samples_ + this->count_);
+}
+
+uint32_t PhaseStats::avg() const {
+  if (this->count_ == 0)
+    return 0;
+  uint64_t sum = 0;
+  for (uint8_t i = 0; i < this->count_; i++)
+    sum += this->samples_[i];
+  return sum / this->count_;
+}
+
+uint32_t PhaseStats::p95() const {
+  if (this->count_ == 0)
+    return 0;
+  // Nearest rank on a sorted copy; the window is tiny.
+  uint32_t sorted[SIZE];
+  std::copy(this->samples_, this->samples_ + this->count_, sorted);
+  std::sort(sorted, sorted + this->count_);
+  return sorted[(this->count_ * 95 + 99) / 100 - 1];
+}
 
 // ========================================================
 // CrowPanelEPaperBase Implementation - SPI Communication
 // ========================================================
 
-void CrowPanelEPaperBase::setup_pins_() {
+bool CrowPanelEPaperBase::setup_pins_() {
   // Configure all the GPIO pins
   this->dc_pin_->setup();
   this->dc_pin_->digital_write(true);
   this->cs_pin_->setup();
   this->cs_pin_->digital_write(true); // Initialize CS high (inactive)
-  this->clk_pin_->setup();
-  this->clk_pin_->digital_write(false); // Clock low initially
-  this->mosi_pin_->setup();
+  if (this->bus_ != nullptr) {
+    // A shared transport is set up by its bus
+    if (this->bus_->is_failed())
+      return false;
+  } else if (!this->transport_->setup()) {
+    return false;
+  }
 
   if (this->reset_pin_ != nullptr)
     this->reset_pin_->setup();
   if (this->busy_pin_ != nullptr) {
-    this->busy_pin_->pin_mode(gpio::FLAG_INPUT);
-  }
-}
-
-void CrowPanelEPaperBase::write_byte_soft_spi(uint8_t data) {
-  for (uint8_t i = 0; i < 8; i++) {
-    this->clk_pin_->digital_write(false); // SCK Low
-    if (data & 0x80) {
-      this->mosi_pin_->digital_write(true); // MOSI High
-    } else {
-      this->mosi_pin_->digital_write(false); // MOSI Low
+    this->busy_pin_->setup();
+    this->busy_interrupt_ = this->busy_pin_->is_internal();
+    if (this->busy_interrupt_) {
+      static_cast<InternalGPIOPin *>(this->busy_pin_)
+          ->attach_interrupt(&CrowPanelEPaperBase::busy_isr_, this, gpio::INTERRUPT_FALLING_EDGE);
     }
-    this->clk_pin_->digital_write(true); // SCK High (Clock in data)
-    data <<= 1; // Shift next bit into position
   }
+  return true;
 }
 
 void CrowPanelEPaperBase::command(uint8_t value) {
-  this->start_command_();
-  this->write_byte_soft_spi(value);
-  this->end_command_();
+  this->start_write_(value);
+  this->end_data_();
 }
 
 void CrowPanelEPaperBase::data(uint8_t value) {
   this->start_data_();
-  this->write_byte_soft_spi(value);
+  this->write_byte_(value);
   this->end_data_();
 }
 
 void CrowPanelEPaperBase::start_command_() {
+  this->bus_command_ = true;
   this->dc_pin_->digital_write(false); // DC Low for command
   this->cs_pin_->digital_write(false); // CS Low (Enable chip)
 }
 
-void CrowPanelEPaperBase::end_command_() {
-  this->cs_pin_->digital_write(true); // CS High (Disable chip)
-  this->dc_pin_->digital_write(true); // Set DC back high (safer default?)
-}
-
 void CrowPanelEPaperBase::start_data_() {
+  this->bus_command_ = false;
   this->dc_pin_->digital_write(true); // DC High for data
   this->cs_pin_->digital_write(false); // CS Low (Enable chip)
 }
 
 void CrowPanelEPaperBase::end_data_() {
+  this->transport_->flush();
   this->cs_pin_->digital_write(true); // CS High (Disable chip)
 }
 
-void CrowPanelEPaperBase::send_command_sequence_(const uint8_t* sequence) {
-  if (sequence == nullptr)
-    return;
-    
-  uint32_t i = 0;
+void CrowPanelEPaperBase::start_write_(uint8_t command) {
+  // Bus trace, compiled in with the logger at VERBOSE.
+  ESP_LOGV(TAG, "Command 0x%02X -> %s", command & ~CMD_TARGET_SECONDARY,
+           (command & CMD_TARGET_SECONDARY) ? "secondary" : "primary");
+  this->start_command_();
+  this->write_byte_(command);
+  // D/C is sampled with the last bit of each byte, CS doesn't have to go up in between.
+  this->transport_->flush();
+  this->bus_command_ = false;
+  this->dc_pin_->digital_write(true);
+}
+
+void CrowPanelEPaperBase::transfer_array_(uint8_t command, const uint8_t *args, size_t len) {
+  this->start_write_(command);
+  this->write_array_(args, len);
+  this->end_data_();
+}
+
+bool CrowPanelEPaperBase::send_sequence_until_wait_(SequenceCursor *cursor) {
+  const uint8_t *sequence = cursor->sequence;
+  uint32_t &i = cursor->index;
   while (true) {
     uint8_t cmd = sequence[i++];
     uint8_t num_args = sequence[i++];
     
     // End marker check
     if (cmd == COMMAND_END_MARKER && num_args == COMMAND_END_MARKER)
-      break;
+      return true;
       
-    this->command(cmd);
+    cursor->delay_ms = (num_args & DELAY_FLAG) ? sequence[i++] : 0;
+    cursor->wait_busy = (num_args & WAIT_BUSY_FLAG) != 0;
     
-    // Check if this command has a delay parameter
-    if (num_args & DELAY_FLAG) {
-      // This is a delay command, skip the delay value
-      // TODO: The delay should be handled by the state machine 
-      uint8_t delay_ms = sequence[i++];
-      delay(delay_ms);
-      // i++;
-      // Continue sending commands (don't break)
-      num_args &= ARG_COUNT_MASK; // Clear delay bit for arg count
-    }
+    // Send the command with all its args
+    num_args &= ARG_COUNT_MASK;
+    this->transfer_array_(cmd, sequence + i, num_args);
+    i += num_args;
     
-    // Send all args
-    for (uint8_t j = 0; j < num_args; j++) {
-      this->data(sequence[i++]);
-    }
+    if (cursor->delay_ms != 0 || cursor->wait_busy)
+      return false;  // Let the caller do the waiting
+  }
+}
+
+void CrowPanelEPaperBase::send_command_sequence_(const uint8_t* sequence) {
+  if (sequence == nullptr)
+    return;
+
+  SequenceCursor cursor{sequence};
+  while (!this->send_sequence_until_wait_(&cursor)) {
+    delay(cursor.delay_ms);
+    const uint32_t start = millis();
+    while (cursor.wait_busy && !this->is_idle_() && millis() - start <= this->idle_timeout_())
+      delay(1);
+  }
+}
+
+void CrowPanelEPaperBase::start_sequence_(const uint8_t *sequence, EpdState next_state) {
+  this->sequence_ = SequenceCursor{sequence};
+  this->sequence_next_state_ = next_state;
+  this->state_ = EpdState::RUN_SEQUENCE;
+  this->state_start_time_ = millis();
+}
+
+void CrowPanelEPaperBase::run_sequence_(uint32_t now) {
+  SequenceCursor &cursor = this->sequence_;
+  if (cursor.delay_ms != 0) {
+    if (now - this->state_start_time_ < cursor.delay_ms)
+      return;
+    cursor.delay_ms = 0;
+    this->state_start_time_ = now;  // The busy timeout starts after the delay
+    if (cursor.wait_busy)
+      this->arm_busy_wait_();
+  }
+  if (cursor.wait_busy) {
+    if (!this->busy_wait_done_(now))
+      return;
+    cursor.wait_busy = false;
+  }
+
+  this->state_start_time_ = now;
+  if (cursor.sequence == nullptr || this->send_sequence_until_wait_(&cursor)) {
+    // The states following a sequence wait for BUSY, starting from here.
+    this->arm_busy_wait_();
+    this->state_ = this->sequence_next_state_;
+  } else if (cursor.delay_ms == 0) {
+    this->arm_busy_wait_();
   }
 }
 
@@ -204,34 +358,37 @@ bool CrowPanelEPaperBase::is_idle_() {
   return !this->check_busy_pin_();
 }
 
-bool CrowPanelEPaperBase::calculate_rotated_coords_(int x, int y, int width, int height, int *out_x, int *out_y) {
-  switch (this->rotation_) {
-    case display::DISPLAY_ROTATION_0_DEGREES:
-      *out_x = x;
-      *out_y = y;
-      break;
-    case display::DISPLAY_ROTATION_90_DEGREES:
-      *out_x = y;
-      *out_y = width - 1 - x;
-      break;
-    case display::DISPLAY_ROTATION_180_DEGREES:
-      *out_x = width - 1 - x;
-      *out_y = height - 1 - y;
-      break;
-    case display::DISPLAY_ROTATION_270_DEGREES:
-      *out_x = height - 1 - y;
-      *out_y = x;
-      break;
-    default:
-      // Invalid rotation
-      return false;
+void IRAM_ATTR CrowPanelEPaperBase::busy_isr_(CrowPanelEPaperBase *arg) {
+  arg->busy_released_us_ = micros();
+  arg->busy_released_ = true;
+#ifdef CROWPANEL_EPAPER_LOOP_CONTROL
+  arg->enable_loop_soon_any_context();
+#endif
+}
+
+void CrowPanelEPaperBase::arm_busy_wait_() {
+  // Clear the flag before looking at the pin, so an edge in between is never lost.
+  this->busy_released_ = false;
+  if (this->is_idle_()) {
+    // Already low, there won't be an edge to wait for
+    this->busy_released_us_ = micros();
+    this->busy_released_ = true;
   }
-  
-  // Check if the rotated coordinates are within the display bounds
-  if (*out_x >= width || *out_y >= height || *out_x < 0 || *out_y < 0)
-    return false;
-    
-  return true;
+}
+
+bool CrowPanelEPaperBase::busy_wait_done_(uint32_t now) {
+  if (this->busy_released_)
+    return true;
+  if (!this->busy_interrupt_ && this->is_idle_()) {
+    this->busy_released_us_ = micros();
+    this->busy_released_ = true;
+    return true;
+  }
+  if (now - this->state_start_time_ > this->idle_timeout_()) {
+    ESP_LOGW(TAG, "Timed out waiting for the panel to become idle");
+    return true;
+  }
+  return false;
 }
 
 void CrowPanelEPaperBase::setup() {
@@ -239,9 +396,38 @@ void CrowPanelEPaperBase::setup() {
   
   uint32_t buffer_size = this->get_buffer_length_();
   this->init_internal_(buffer_size);
+  if (this->buffer_ == nullptr) {
+    this->mark_failed();
+    return;
+  }
+
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  this->previous_buffer_ = allocator.allocate(buffer_size);
+  if (this->previous_buffer_ == nullptr) {
+    ESP_LOGW(TAG, "Could not allocate previous frame buffer, partial updates will send the whole frame");
+  }
+  if (this->background_writer_) {
+    this->background_ = allocator.allocate(buffer_size);
+    if (this->background_ == nullptr)
+      ESP_LOGW(TAG, "Could not allocate background layer, it is drawn with every frame");
+  }
+  this->transfer_buffer_ = this->buffer_;
+  if (this->double_buffer_) {
+    this->transfer_buffer_ = allocator.allocate(buffer_size);
+    if (this->transfer_buffer_ == nullptr) {
+      ESP_LOGW(TAG, "Could not allocate second frame buffer, rendering waits for the panel");
+      this->transfer_buffer_ = this->buffer_;
+    }
+  }
   
   this->fill(display::COLOR_OFF);
-  this->setup_pins_();
+  if (!this->setup_pins_()) {
+    ESP_LOGE(TAG, "Transport setup failed");
+    this->mark_failed();
+    return;
+  }
+  if (this->watch_polled_)
+    this->set_interval("watch", this->watch_interval_, [this]() { this->on_watched_change_(); });
   
   // Start initialization state machine
   this->state_ = EpdState::INIT_START;
@@ -249,13 +435,43 @@ void CrowPanelEPaperBase::setup() {
 }
 
 void CrowPanelEPaperBase::loop() {
+  const uint32_t start = micros();
+  this->run_state_machine_(millis());
+  this->max_loop_us_ = std::max(this->max_loop_us_, micros() - start);
+}
+
+void CrowPanelEPaperBase::record_phase_(UpdatePhase phase, uint32_t duration_us) {
+  const uint8_t index = static_cast<uint8_t>(phase);
+  this->phase_stats_[index].add(duration_us);
+#ifdef USE_SENSOR
+  if (this->phase_sensors_[index] != nullptr)
+    this->phase_sensors_[index]->publish_state(duration_us / 1000.0f);
+#endif
+}
+
+void CrowPanelEPaperBase::run_state_machine_(uint32_t now) {
   // Main state machine to handle non-blocking operations
-  uint32_t now = millis();
+
+  if (this->needs_update_ && !this->frame_ready_ && this->can_prerender_()) {
+    // The panel is still busy with the previous frame, draw the next one into the spare buffer.
+    // Rendering gets a loop() of its own.
+    this->render_frame_();
+    this->frame_ready_ = true;
+    ESP_LOGD(TAG, "Rendered next frame ahead of time");
+    return;
+  }
   
   switch (this->state_) {
     case EpdState::IDLE:
-      if (this->needs_update_) {
+      if (this->needs_update_ && this->update_allowed_(now)) {
         this->needs_update_ = false;
+        this->requested_has_mode_ = this->pending_has_mode_;
+        this->requested_mode_ = this->pending_mode_;
+        this->pending_priority_ = UpdatePriority::ROUTINE;
+        this->pending_has_mode_ = false;
+        this->pending_deferred_ = false;
+        this->max_loop_us_ = 0;
+        this->bus_bytes_[0] = this->bus_bytes_[1] = 0;
         this->state_ = EpdState::UPDATE_START;
         this->state_start_time_ = now;
         ESP_LOGD(TAG, "Starting display update");
@@ -303,15 +519,15 @@ void CrowPanelEPaperBase::loop() {
       break;
       
     case EpdState::INIT_SEND_COMMANDS:
+      // Starts the panel's init sequence, which continues with INIT_WAIT_BUSY
       this->initialize();
-      this->state_ = EpdState::INIT_WAIT_BUSY;
-      this->state_start_time_ = now;
       break;
       
     case EpdState::INIT_WAIT_BUSY:
-      if (this->is_idle_() || now - this->state_start_time_ > this->idle_timeout_()) {
+      if (this->busy_wait_done_(now)) {
         this->state_ = EpdState::INIT_DONE;
         this->update_count_ = 0;
+        this->previous_valid_ = false;
         ESP_LOGD(TAG, "Display initialization complete");
       }
       break;
@@ -321,115 +537,691 @@ void CrowPanelEPaperBase::loop() {
       break;
       
     case EpdState::UPDATE_START:
-      this->update_count_++;
+      if (!this->frame_ready_)
+        this->render_frame_();
+      this->frame_ready_ = false;
+      this->swap_buffers_();
       
-      // Determine update mode (forced or automatic)
-      if (this->has_forced_update_mode_) {
-        this->is_full_update_ = (this->force_update_mode_ == UpdateMode::FULL);
-      } else {
-        // Ensure the very first update is always full
-        this->is_full_update_ = (this->update_count_ == 1 || (this->update_count_ % this->full_update_every_ == 0));
+      // Nothing to do if the panel already shows exactly this frame. An explicit FULL or FAST
+      // request is about the panel, e.g. clearing ghosting, so it refreshes all the same.
+      if (!(this->requested_has_mode_ && this->requested_mode_ != UpdateMode::PARTIAL) &&
+          this->is_frame_unchanged_()) {
+        this->skipped_update_count_++;
+        ESP_LOGD(TAG, "Frame unchanged, skipping refresh (%u skipped)", this->skipped_update_count_);
+#ifdef USE_SENSOR
+        if (this->skipped_updates_sensor_ != nullptr)
+          this->skipped_updates_sensor_->publish_state(this->skipped_update_count_);
+#endif
+        this->state_ = EpdState::IDLE;
+        break;
       }
       
-      ESP_LOGD(TAG, "Performing %s display update (%u)", 
-                 this->is_full_update_ ? "FULL" : "PARTIAL", this->update_count_);
+      this->update_count_++;
+      this->record_refresh_start_(now);
       
-      // Clear buffer to white first
-      this->fill(display::COLOR_OFF);
+      // Determine update mode (requested, forced or automatic)
+      if (this->requested_has_mode_ || this->has_forced_update_mode_) {
+        this->invert_old_image_ = false;
+        this->update_mode_ = this->requested_has_mode_ ? this->requested_mode_ : this->force_update_mode_;
+        if (this->update_mode_ == UpdateMode::PARTIAL && this->update_count_ == 1)
+          this->update_mode_ = UpdateMode::FULL;  // The controller RAM holds nothing useful yet
+        if (this->update_mode_ == UpdateMode::FAST)
+          this->update_mode_ = this->resolve_fast_mode_();
+      } else {
+        this->update_mode_ = this->choose_update_mode_(now);
+      }
+      this->is_full_update_ = this->update_mode_ != UpdateMode::PARTIAL;
+      if (this->is_full_update_) {
+        this->last_full_update_ = now;
+        std::fill(std::begin(this->churn_), std::end(this->churn_), 0);
+      }
       
-      // Execute the lambda (if set) - this draws text, shapes, etc.
-      if (this->page_ != nullptr) {
-        this->page_->get_writer()(*this);
-      } else if (this->writer_.has_value()) {
-        (*this->writer_)(*this);
+      ESP_LOGD(TAG, "Performing %s display update (%u)", update_mode_to_string(this->update_mode_),
+               this->update_count_);
+
+      if (this->asleep_) {
+        // Only a hardware reset ends deep sleep
+        this->wake_start_us_ = micros();
+        this->reset_pin_->digital_write(false);
+        this->state_ = EpdState::WAKE_RESET;
+        this->state_start_time_ = now;
+        break;
       }
       
       this->state_ = EpdState::UPDATE_WAIT_BUSY;
       this->state_start_time_ = now;
+      this->busy_wait_start_us_ = micros();
+      this->arm_busy_wait_();
       break;
       
+    case EpdState::WAKE_RESET:
+      if (now - this->state_start_time_ >= 10) {
+        this->reset_pin_->digital_write(true);
+        this->state_ = EpdState::WAKE_WAIT_RESET;
+        this->state_start_time_ = now;
+      }
+      break;
+
+    case EpdState::WAKE_WAIT_RESET:
+      if (now - this->state_start_time_ >= 10) {
+        // The RAM survived, only the registers are back to their defaults
+        this->start_sequence_(this->wake_sequence_(), EpdState::WAKE_DONE);
+      }
+      break;
+
+    case EpdState::WAKE_DONE: {
+      const uint32_t wake_us = micros() - this->wake_start_us_;
+      this->record_phase_(UpdatePhase::WAKE, wake_us);
+      this->asleep_ = false;
+      ESP_LOGD(TAG, "Woke up in %u ms", wake_us / 1000u);
+      this->state_ = EpdState::UPDATE_WAIT_BUSY;
+      this->state_start_time_ = now;
+      this->busy_wait_start_us_ = micros();
+      this->arm_busy_wait_();
+      break;
+    }
+
     case EpdState::UPDATE_WAIT_BUSY:
-      if (this->is_idle_() || now - this->state_start_time_ > this->idle_timeout_()) {
+      if (this->busy_wait_done_(now)) {
+        this->record_phase_(UpdatePhase::WAIT_BUSY, micros() - this->busy_wait_start_us_);
         this->state_ = EpdState::UPDATE_PREPARE;
       }
       break;
       
-    case EpdState::UPDATE_PREPARE:
+    case EpdState::UPDATE_PREPARE: {
+      const uint32_t prepare_start = micros();
       this->display(); // Set up for data transfer
+      this->record_phase_(UpdatePhase::PREPARE, micros() - prepare_start);
+      // Don't wait the usual 16ms between loop() calls while there is data to stream.
+      this->high_freq_.start();
+      this->upload_start_us_ = micros();
+      this->upload_bytes_ = 0;
       this->state_ = EpdState::UPDATE_SENDING_DATA;
       this->state_start_time_ = now;
       break;
+    }
     case EpdState::UPDATE_SENDING_DATA:
       this->update_send_data_(now);
       break;
     case EpdState::UPDATE_REFRESH: {
       // Send refresh command based on update mode
-      UpdateMode mode = this->is_full_update_ ? UpdateMode::FULL : UpdateMode::PARTIAL;
-      if (mode == UpdateMode::FULL) {
-        this->send_command_sequence_(full_refresh_sequence);
-      } else {
-        this->send_command_sequence_(partial_refresh_sequence);
+      const uint8_t *sequence = partial_refresh_sequence.data();
+      if (this->update_mode_ == UpdateMode::FULL) {
+        sequence = full_refresh_sequence.data();
+      } else if (this->update_mode_ == UpdateMode::FAST) {
+        sequence = this->fast_refresh_sequence_();
       }
-      this->state_ = EpdState::UPDATE_WAIT_REFRESH;
-      this->state_start_time_ = now;
+      this->refresh_count_++;
+      this->refresh_start_us_ = micros();
+#ifdef USE_SENSOR
+      if (this->refreshes_sensor_ != nullptr)
+        this->refreshes_sensor_->publish_state(this->refresh_count_);
+#endif
+      this->start_sequence_(sequence, EpdState::UPDATE_WAIT_REFRESH);
       break;
     }
     case EpdState::UPDATE_WAIT_REFRESH:
-      if (this->is_idle_() || now - this->state_start_time_ > this->idle_timeout_()) {
-        this->state_ = EpdState::UPDATE_DONE;
-        ESP_LOGD(TAG, "Display update complete");
+      if (this->busy_wait_done_(now)) {
+        const uint32_t refresh_end = this->busy_released_ ? this->busy_released_us_ : micros();
+        this->refresh_duration_us_ = refresh_end - this->refresh_start_us_;
+        this->record_phase_(UpdatePhase::REFRESH, this->refresh_duration_us_);
+#ifdef CROWPANEL_EPAPER_LOOP_CONTROL
+        this->cancel_timeout("busy_timeout");
+#endif
+        ESP_LOGD(TAG, "Display update complete, refresh took %u ms", this->refresh_duration_us_ / 1000u);
+        // The next partial refresh compares against the old-image RAM, which still holds
+        // whatever was written there before this frame.
+        this->start_upload_pass_(UploadPass::SYNC_OLD_IMAGE);
+        this->high_freq_.start();
+        this->state_ = EpdState::UPDATE_SYNC_OLD_IMAGE;
+      }
+#ifdef CROWPANEL_EPAPER_LOOP_CONTROL
+      else if (this->busy_interrupt_) {
+        // The refresh takes seconds and the BUSY interrupt wakes loop() up again. update() and the
+        // timeout below cover a new frame to pre-render and a falling edge that never comes. loop()
+        // gets here again after each update(), so the timeout only covers what's left of the wait.
+        const uint32_t remaining = this->idle_timeout_() - (now - this->state_start_time_) + 1;
+        this->set_timeout("busy_timeout", remaining, [this]() { this->enable_loop(); });
+        this->disable_loop();
       }
+#endif
       break;
       
+    case EpdState::UPDATE_SYNC_OLD_IMAGE:
+      this->update_send_data_(now);
+      break;
+
     case EpdState::UPDATE_DONE:
+      // The call that finishes the update is not included, it does next to nothing.
+      this->record_phase_(UpdatePhase::LOOP, this->max_loop_us_);
+      ESP_LOGD(TAG, "Bus: %u command and %u data bytes", this->bus_bytes_[1], this->bus_bytes_[0]);
+#ifdef USE_SENSOR
+      if (this->bus_bytes_sensor_ != nullptr)
+        this->bus_bytes_sensor_->publish_state(this->bus_bytes_[0] + this->bus_bytes_[1]);
+#endif
+      if (this->sleep_between_updates_ && this->reset_pin_ != nullptr) {
+        this->deep_sleep();
+        this->asleep_ = true;
+      }
       this->state_ = EpdState::IDLE;
       break;
       
+    case EpdState::RUN_SEQUENCE:
+      this->run_sequence_(now);
+      break;
+      
     case EpdState::DEEP_SLEEP:
       // Stay in deep sleep state
       break;
   }
 }
 
+void CrowPanelEPaperBase::render_frame_() {
+  const uint32_t start = micros();
+  this->draw_frame_();
+  this->record_phase_(UpdatePhase::RENDER, micros() - start);
+}
+
+void CrowPanelEPaperBase::draw_frame_() {
+  const display::DisplayPage *page = this->page_;
+  PageCacheEntry *entry = this->page_cache_ && page != nullptr ? this->page_cache_entry_(page) : nullptr;
+  const bool page_switched = page != this->last_drawn_page_;
+  this->last_drawn_page_ = page;
+  if (entry != nullptr && entry->valid && page_switched) {
+    memcpy(this->buffer_, entry->frame, this->get_buffer_length_());
+    ESP_LOGD(TAG, "Page switch served from the page cache");
+    return;
+  }
+
+  // Taken before the writer runs, a change while it runs asks for another frame.
+  const uint32_t generation = this->watch_generation_;
+  this->draw_content_();
+  this->drawn_generation_ = generation;
+
+  if (entry != nullptr) {
+    memcpy(entry->frame, this->buffer_, this->get_buffer_length_());
+    entry->valid = true;
+  }
+}
+
+void CrowPanelEPaperBase::draw_content_() {
+  this->draw_background_();
+
+  // Execute the lambda (if set) - this draws text, shapes, etc.
+  if (this->page_ != nullptr) {
+    this->page_->get_writer()(*this);
+  } else if (this->writer_.has_value()) {
+    (*this->writer_)(*this);
+  }
+}
+
+void CrowPanelEPaperBase::draw_background_() {
+  if (this->background_valid_) {
+    memcpy(this->buffer_, this->background_, this->get_buffer_length_());
+    return;
+  }
+
+  // Clear buffer to white first
+  this->fill(display::COLOR_OFF);
+  if (!this->background_writer_)
+    return;
+  this->background_writer_(*this);
+  if (this->background_ != nullptr) {
+    memcpy(this->background_, this->buffer_, this->get_buffer_length_());
+    this->background_valid_ = true;
+  }
+}
+
+CrowPanelEPaperBase::PageCacheEntry *CrowPanelEPaperBase::page_cache_entry_(const display::DisplayPage *page) {
+  for (auto &entry : this->page_cache_entries_) {
+    if (entry.page == page)
+      return entry.frame != nullptr ? &entry : nullptr;
+  }
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *frame = allocator.allocate(this->get_buffer_length_());
+  if (frame == nullptr)
+    ESP_LOGW(TAG, "Could not allocate a page cache frame, this page is rendered every time");
+  // Remembered either way, so a failed allocation isn't retried on every update.
+  this->page_cache_entries_.push_back({page, frame, false});
+  return frame != nullptr ? &this->page_cache_entries_.back() : nullptr;
+}
+
+void CrowPanelEPaperBase::invalidate_page_cache(const display::DisplayPage *page) {
+  for (auto &entry : this->page_cache_entries_) {
+    if (page == nullptr || entry.page == page)
+      entry.valid = false;
+  }
+}
+
+void CrowPanelEPaperBase::swap_buffers_() {
+  // Only ever called from UPDATE_START, when nothing is reading the transfer buffer.
+  std::swap(this->buffer_, this->transfer_buffer_);
+}
+
+bool CrowPanelEPaperBase::can_prerender_() {
+  if (this->transfer_buffer_ == this->buffer_)
+    return false;
+  switch (this->state_) {
+    case EpdState::IDLE:
+    case EpdState::UPDATE_START:
+    case EpdState::DEEP_SLEEP:
+      // Either the update is about to render anyway, or there is no panel to draw for.
+      return false;
+    default:
+      return true;
+  }
+}
+
 void CrowPanelEPaperBase::update_send_data_(uint32_t now) {
-  // Send a chunk of data per loop
-  const size_t CHUNK_SIZE = 32;
-  size_t buffer_len = this->get_buffer_length_();
-  size_t i = this->data_send_index_;
-  size_t end = (i + CHUNK_SIZE < buffer_len) ? (i + CHUNK_SIZE) : buffer_len;
-  for (; i < end; ++i) {
-    this->write_byte_soft_spi(this->buffer_[i]);
-  }
-  this->data_send_index_ = end;
-  if (this->data_send_index_ >= buffer_len) {
+  if (!this->send_window_budgeted_(this->update_window_))
+    return;
+  this->end_data_();
+  this->finish_upload_pass_(now);
+}
+
+void CrowPanelEPaperBase::start_upload_pass_(UploadPass pass) {
+  this->upload_pass_ = pass;
+  this->data_send_index_ = 0;
+  this->begin_ram_write_(this->ram_command_());
+}
+
+void CrowPanelEPaperBase::begin_ram_write_(uint8_t command) {
+  this->start_ram_write_(command);
+  // The controller keeps writing RAM where it left off once it's selected again, so the bus is
+  // free for other panels until the first slice.
+  if (this->bus_ != nullptr)
     this->end_data_();
-    this->state_ = EpdState::UPDATE_REFRESH;
-    this->state_start_time_ = now;
+}
+
+void CrowPanelEPaperBase::finish_upload_pass_(uint32_t now) {
+  switch (this->upload_pass_) {
+    case UploadPass::NEW_IMAGE:
+      if (this->invert_old_image_) {
+        this->start_upload_pass_(UploadPass::CLEAN_OLD_IMAGE);
+        break;
+      }
+      this->finish_upload_(now);
+      break;
+    case UploadPass::CLEAN_OLD_IMAGE:
+      this->finish_upload_(now);
+      break;
+    case UploadPass::SYNC_OLD_IMAGE:
+      this->high_freq_.stop();
+      this->state_ = EpdState::UPDATE_DONE;
+      break;
+  }
+}
+
+uint8_t CrowPanelEPaperBase::ram_command_() {
+  return this->upload_pass_ == UploadPass::NEW_IMAGE ? CMD_WRITE_RAM : CMD_WRITE_OLD_RAM;
+}
+
+bool CrowPanelEPaperBase::send_window_budgeted_(const RamWindow &window) {
+  if (this->bus_ != nullptr) {
+    if (!this->bus_->claim_slice(this))
+      return false;  // Another panel's turn
+    this->start_data_();
+  }
+  // Queued DMA writes return before the bytes are out, so timing them says nothing about the
+  // wire. Wait for the last chunk instead and queue what the wire sends in half the budget:
+  // draining it before the next chunk, or at the end of the window, leaves loop() within budget.
+  const float wire_rate = this->transport_->wire_rate();
+  if (wire_rate > 0.0f) {
+    this->transport_->flush();
+    this->send_rate_ = wire_rate;
+  }
+  const float budget_us = wire_rate > 0.0f ? this->send_budget_us_ / 2.0f : this->send_budget_us_;
+  const size_t max_bytes = std::max<size_t>(MIN_SEND_CHUNK, this->send_rate_ * budget_us);
+  const uint32_t index = this->data_send_index_;
+  const uint32_t start = micros();
+  const bool done = this->send_window_chunk_(window, max_bytes);
+  const uint32_t elapsed = std::max<uint32_t>(1, micros() - start);
+  const uint32_t sent = this->data_send_index_ - index;
+  this->upload_bytes_ += sent;
+
+  // Chunks that filled the budget say the most about the rate, the tail of a window is mostly
+  // per-row overhead. A chunk that overran the budget counts as well, so a rate that was too high
+  // comes down again.
+  if (wire_rate == 0.0f && sent > 0 && (sent == max_bytes || elapsed > this->send_budget_us_)) {
+    const float rate = static_cast<float>(sent) / elapsed;
+    this->send_rate_ = this->send_rate_ == 0.0f ? rate : 0.75f * this->send_rate_ + 0.25f * rate;
+  }
+  if (this->bus_ != nullptr) {
+    this->end_data_();
+    this->bus_->end_slice(this, !done);
+  }
+  return done;
+}
+
+void CrowPanelEPaperBase::finish_upload_(uint32_t now) {
+  this->commit_window_();
+  this->high_freq_.stop();
+
+  const uint32_t elapsed = std::max<uint32_t>(1, micros() - this->upload_start_us_);
+  // Bytes per microsecond is kB/s.
+  this->upload_throughput_ = static_cast<float>(this->upload_bytes_) * 1000.0f / elapsed;
+  ESP_LOGD(TAG, "Sent %u bytes in %u us (%.1f kB/s)", this->upload_bytes_, elapsed, this->upload_throughput_);
+  this->record_phase_(UpdatePhase::SEND, elapsed);
+#ifdef USE_SENSOR
+  if (this->upload_throughput_sensor_ != nullptr)
+    this->upload_throughput_sensor_->publish_state(this->upload_throughput_);
+#endif
+
+  this->state_ = EpdState::UPDATE_REFRESH;
+  this->state_start_time_ = now;
+}
+
+void CrowPanelEPaperBase::prepare_window_() {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t rows = this->get_buffer_length_() / stride;
+  this->update_window_ = {0, static_cast<uint16_t>(stride - 1), 0, static_cast<uint16_t>(rows - 1)};
+  this->data_send_index_ = 0;
+  this->upload_pass_ = UploadPass::NEW_IMAGE;
+
+  if (this->is_full_update_ || !this->previous_valid_)
+    return;
+  RamWindow &window = this->update_window_;
+  if (!this->find_dirty_window_(&window))
+    return;
+  if (this->invert_old_image_) {
+    // The regions being cleaned go out as well, changed or not.
+    window.x_start = std::min(window.x_start, this->clean_window_.x_start);
+    window.x_end = std::max(window.x_end, this->clean_window_.x_end);
+    window.y_start = std::min(window.y_start, this->clean_window_.y_start);
+    window.y_end = std::max(window.y_end, this->clean_window_.y_end);
   }
+  ESP_LOGD(TAG, "Partial window: columns %u-%u, rows %u-%u (%zu of %u bytes)", window.x_start, window.x_end,
+           window.y_start, window.y_end, window.size(), this->get_buffer_length_());
+}
+
+bool CrowPanelEPaperBase::find_dirty_window_(RamWindow *window) {
+  if (this->previous_buffer_ == nullptr)
+    return false;
+
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t rows = this->get_buffer_length_() / stride;
+  const uint8_t *current = this->transfer_buffer_;
+  const uint8_t *previous = this->previous_buffer_;
+
+  // Rows first, they are contiguous and memcmp is fast.
+  int top = 0;
+  while (top < rows && memcmp(current + top * stride, previous + top * stride, stride) == 0)
+    top++;
+  if (top == rows)
+    return false;  // Nothing changed
+  int bottom = rows - 1;
+  while (bottom > top && memcmp(current + bottom * stride, previous + bottom * stride, stride) == 0)
+    bottom--;
+
+  // Then narrow the columns within those rows.
+  int left = stride - 1;
+  int right = 0;
+  for (int y = top; y <= bottom; y++) {
+    const uint8_t *cur_row = current + y * stride;
+    const uint8_t *prev_row = previous + y * stride;
+    for (int x = 0; x < left; x++) {
+      if (cur_row[x] != prev_row[x]) {
+        left = x;
+        break;
+      }
+    }
+    for (int x = stride - 1; x > right; x--) {
+      if (cur_row[x] != prev_row[x]) {
+        right = x;
+        break;
+      }
+    }
+  }
+
+  window->x_start = left;
+  window->x_end = right;
+  window->y_start = top;
+  window->y_end = bottom;
+  return true;
+}
+
+bool CrowPanelEPaperBase::narrow_dirty_rows_(RamWindow *window) {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t width = window->width_bytes();
+  auto row_changed = [&](int y) {
+    const size_t offset = y * stride + window->x_start;
+    return memcmp(this->transfer_buffer_ + offset, this->previous_buffer_ + offset, width) != 0;
+  };
+
+  int top = window->y_start;
+  while (top <= window->y_end && !row_changed(top))
+    top++;
+  if (top > window->y_end)
+    return false;
+  int bottom = window->y_end;
+  while (bottom > top && !row_changed(bottom))
+    bottom--;
+  window->y_start = top;
+  window->y_end = bottom;
+  return true;
+}
+
+bool CrowPanelEPaperBase::send_window_chunk_(const RamWindow &window, size_t max_bytes) {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t width = window.width_bytes();
+  const size_t total = window.size();
+
+  size_t sent = 0;
+  while (sent < max_bytes && this->data_send_index_ < total) {
+    const uint32_t row = window.y_start + this->data_send_index_ / width;
+    const uint32_t column = this->data_send_index_ % width;
+    // Each row of the window is contiguous in the buffer, so it goes out as a single burst. Rows
+    // spanning the whole buffer width follow each other, then the rest of the window does.
+    const size_t run = width == stride ? total - this->data_send_index_ : width - column;
+    size_t len = std::min<size_t>(run, max_bytes - sent);
+    const uint8_t *src = this->transfer_buffer_ + row * stride + window.x_start + column;
+    if (this->upload_pass_ != UploadPass::CLEAN_OLD_IMAGE) {
+      this->write_array_(src, len);
+    } else {
+      // The old image is the inverse of the new one, so the controller drives every pixel.
+      uint8_t inverted[64];
+      len = std::min(len, sizeof(inverted));
+      for (size_t i = 0; i < len; i++)
+        inverted[i] = ~src[i];
+      this->write_array_(inverted, len);
+    }
+    this->data_send_index_ += len;
+    sent += len;
+  }
+  return this->data_send_index_ >= total;
+}
+
+bool CrowPanelEPaperBase::is_frame_unchanged_() {
+  // The retained copy of the last upload doubles as the frame fingerprint.
+  if (!this->previous_valid_ || this->previous_buffer_ == nullptr)
+    return false;
+  return memcmp(this->transfer_buffer_, this->previous_buffer_, this->get_buffer_length_()) == 0;
+}
+
+void CrowPanelEPaperBase::commit_window_() {
+  if (this->previous_buffer_ == nullptr)
+    return;
+  if (this->churn_threshold_ > 0.0f && !this->is_full_update_ && this->previous_valid_)
+    this->track_churn_();
+  if (this->invert_old_image_)
+    this->reset_churn_(this->clean_window_);
+  // Outside the window both buffers already match, so copying whole rows is fine.
+  const uint16_t stride = this->get_row_stride_();
+  const size_t offset = this->update_window_.y_start * stride;
+  memcpy(this->previous_buffer_ + offset, this->transfer_buffer_ + offset, this->update_window_.height() * stride);
+  this->previous_valid_ = true;
 }
 
 void CrowPanelEPaperBase::update() {
+  if (!this->watched_.empty() && !this->probe_watched_() && this->page_ == this->last_drawn_page_) {
+    ESP_LOGV(TAG, "Watched sources unchanged, not redrawing");
+    return;
+  }
+  this->request_update(UpdatePriority::ROUTINE);
+}
+
+// ========================================================
+// CrowPanelEPaperBase Implementation - Update Requests
+// ========================================================
+
+// How thoroughly a mode redraws the panel, for merging requests.
+static uint8_t mode_strength(UpdateMode mode) {
+  switch (mode) {
+    case UpdateMode::FULL:
+      return 2;
+    case UpdateMode::FAST:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+void CrowPanelEPaperBase::request_update(UpdatePriority priority) {
+  this->queue_request_(priority, false, UpdateMode::FULL);
+}
+
+void CrowPanelEPaperBase::request_update(UpdatePriority priority, UpdateMode mode) {
+  this->queue_request_(priority, true, mode);
+}
+
+void CrowPanelEPaperBase::queue_request_(UpdatePriority priority, bool has_mode, UpdateMode mode) {
+  if (!this->needs_update_) {
+    this->pending_priority_ = priority;
+    this->pending_has_mode_ = has_mode;
+    this->pending_mode_ = mode;
+  } else {
+    if (priority > this->pending_priority_)
+      this->pending_priority_ = priority;
+    if (has_mode && (!this->pending_has_mode_ || mode_strength(mode) > mode_strength(this->pending_mode_))) {
+      this->pending_has_mode_ = true;
+      this->pending_mode_ = mode;
+    }
+    ESP_LOGV(TAG, "Update request merged into the pending one");
+  }
   this->do_update_();
+#ifdef CROWPANEL_EPAPER_LOOP_CONTROL
+  this->enable_loop();
+#endif
+}
+
+bool CrowPanelEPaperBase::update_allowed_(uint32_t now) {
+  // Nothing holds back the first frame after setup, or an urgent one.
+  if (this->pending_priority_ == UpdatePriority::URGENT || this->update_count_ == 0)
+    return true;
+
+  const char *reason = nullptr;
+  if (this->min_update_interval_ != 0 && now - this->last_refresh_start_ < this->min_update_interval_) {
+    reason = "minimum interval";
+  } else if (this->max_refreshes_per_hour_ != 0 && this->refresh_history_.size() >= this->max_refreshes_per_hour_ &&
+             now - this->refresh_history_.front() < 3600000u) {
+    reason = "hourly refresh budget";
+  }
+  if (reason == nullptr)
+    return true;
+  if (!this->pending_deferred_) {
+    ESP_LOGD(TAG, "Update deferred by the %s", reason);
+    this->pending_deferred_ = true;
+  }
+  return false;
+}
+
+void CrowPanelEPaperBase::record_refresh_start_(uint32_t now) {
+  this->last_refresh_start_ = now;
+  if (this->max_refreshes_per_hour_ == 0)
+    return;
+  if (this->refresh_history_.size() >= this->max_refreshes_per_hour_)
+    this->refresh_history_.erase(this->refresh_history_.begin());
+  this->refresh_history_.push_back(now);
 }
 
 void CrowPanelEPaperBase::do_update_() {
   // Just set the flag - actual update will happen in loop()
   this->needs_update_ = true;
+  // A frame rendered ahead of time is stale now
+  this->frame_ready_ = false;
+}
+
+// ========================================================
+// CrowPanelEPaperBase Implementation - Watched Sources
+// ========================================================
+
+void CrowPanelEPaperBase::add_watch_probe(std::function<uint32_t()> &&probe, bool polled) {
+  const uint32_t hash = probe();
+  this->watched_.push_back({std::move(probe), hash});
+  this->watch_polled_ |= polled;
+}
+
+#ifdef USE_SENSOR
+void CrowPanelEPaperBase::add_watched_sensor(sensor::Sensor *sensor) {
+  this->add_watch_probe([sensor]() { return watch_hash(sensor->state); }, false);
+  // Publishing the same value again doesn't count, the probe filters it out.
+  sensor->add_on_state_callback([this](float) { this->on_watched_change_(); });
+}
+#endif
+
+#ifdef USE_TEXT_SENSOR
+void CrowPanelEPaperBase::add_watched_text_sensor(text_sensor::TextSensor *sensor) {
+  this->add_watch_probe([sensor]() { return watch_hash(sensor->state); }, false);
+  sensor->add_on_state_callback([this](const std::string &) { this->on_watched_change_(); });
+}
+#endif
+
+#ifdef USE_TIME
+void CrowPanelEPaperBase::set_watched_time(time::RealTimeClock *clock, uint32_t granularity_s) {
+  this->add_watch_probe(
+      [clock, granularity_s]() -> uint32_t {
+        const ESPTime time = clock->now();
+        if (!time.is_valid())
+          return 0;
+        // Local time, so an hourly granularity follows the hours shown
+        const uint32_t seconds = ((time.day_of_year * 24u + time.hour) * 60u + time.minute) * 60u + time.second;
+        return seconds / granularity_s + 1;
+      },
+      true);
+}
+#endif
+
+bool CrowPanelEPaperBase::probe_watched_() {
+  bool changed = false;
+  for (auto &source : this->watched_) {
+    const uint32_t hash = source.probe();
+    if (hash != source.hash) {
+      source.hash = hash;
+      changed = true;
+    }
+  }
+  if (changed) {
+    this->watch_generation_++;
+    // The cached pages show the old values too.
+    this->invalidate_page_cache();
+  }
+  return this->watch_generation_ != this->drawn_generation_;
+}
+
+void CrowPanelEPaperBase::on_watched_change_() {
+  // A pending update that hasn't been drawn yet will pick the change up anyway.
+  if ((this->needs_update_ && !this->frame_ready_) || !this->probe_watched_())
+    return;
+  ESP_LOGD(TAG, "Watched source changed, updating");
+  this->update();
 }
 
 void CrowPanelEPaperBase::on_safe_shutdown() { 
+  this->high_freq_.stop();
+  if (this->bus_ != nullptr)
+    this->bus_->end_slice(this, false);  // Don't leave the other panels waiting
+
   this->state_ = EpdState::DEEP_SLEEP;
   this->deep_sleep(); 
 }
 
 void CrowPanelEPaperBase::dump_config() {
-    LOG_DISPLAY("", "CrowPanel E-Paper (Software SPI)", this);
+    LOG_DISPLAY("", "CrowPanel E-Paper", this);
     LOG_PIN("  CS Pin: ", this->cs_pin_);
     LOG_PIN("  DC Pin: ", this->dc_pin_);
     LOG_PIN("  Reset Pin: ", this->reset_pin_);
     LOG_PIN("  Busy Pin: ", this->busy_pin_);
-    LOG_PIN("  CLK Pin: ", this->clk_pin_);
-    LOG_PIN("  MOSI Pin: ", this->mosi_pin_);
+    this->transport_->dump_config();
     ESP_LOGCONFIG(TAG, "  Full Update Every: %u", this->full_update_every_);
     
     const char *rotation_str;
@@ -452,11 +1244,212 @@ void CrowPanelEPaperBase::dump_config() {
     ESP_LOGCONFIG(TAG, "  Rotation: %s", rotation_str);
     
     if (this->has_forced_update_mode_) {
-      ESP_LOGCONFIG(TAG, "  Forced Update Mode: %s", 
-        this->force_update_mode_ == UpdateMode::FULL ? "FULL" : "PARTIAL");
+      ESP_LOGCONFIG(TAG, "  Forced Update Mode: %s", update_mode_to_string(this->force_update_mode_));
     }
 }
 
+// ========================================================
+// CrowPanelEPaperBase Implementation - Full Update Scheduling
+// ========================================================
+
+UpdateMode CrowPanelEPaperBase::choose_update_mode_(uint32_t now) {
+  this->invert_old_image_ = false;
+  // Ensure the very first update is always full
+  if (this->update_count_ == 1)
+    return UpdateMode::FULL;
+
+  const char *reason = nullptr;
+  bool churn = false;
+  if (this->full_update_max_interval_ != 0 && now - this->last_full_update_ >= this->full_update_max_interval_) {
+    reason = "time limit";
+  } else if (this->churn_threshold_ > 0.0f) {
+    churn = this->find_hot_regions_(&this->clean_window_);
+    if (churn)
+      reason = "churn";
+  } else if (this->update_count_ % this->full_update_every_ == 0) {
+    reason = "update count";
+  }
+  if (reason == nullptr && this->full_update_postponed_)
+    reason = "postponed";  // The update count has moved on since
+  if (reason == nullptr)
+    return UpdateMode::PARTIAL;
+
+  if (this->in_quiet_hours_()) {
+    ESP_LOGD(TAG, "Full update due (%s) but postponed for quiet hours", reason);
+    this->full_update_postponed_ = true;
+    return UpdateMode::PARTIAL;
+  }
+  this->full_update_postponed_ = false;
+  if (churn && this->regional_full_update_ && this->previous_buffer_ != nullptr) {
+    ESP_LOGD(TAG, "Cleaning columns %u-%u, rows %u-%u", this->clean_window_.x_start, this->clean_window_.x_end,
+             this->clean_window_.y_start, this->clean_window_.y_end);
+    this->invert_old_image_ = true;
+    return UpdateMode::PARTIAL;
+  }
+  ESP_LOGD(TAG, "Full update due (%s)", reason);
+  return UpdateMode::FULL;
+}
+
+bool CrowPanelEPaperBase::in_quiet_hours_() {
+#ifdef USE_TIME
+  if (this->quiet_clock_ == nullptr)
+    return false;
+  const ESPTime time = this->quiet_clock_->now();
+  if (!time.is_valid())
+    return false;
+  const uint16_t minute = time.hour * 60u + time.minute;
+  if (this->quiet_start_ <= this->quiet_end_)
+    return minute >= this->quiet_start_ && minute < this->quiet_end_;
+  return minute >= this->quiet_start_ || minute < this->quiet_end_;  // Across midnight
+#else
+  return false;
+#endif
+}
+
+void CrowPanelEPaperBase::track_churn_() {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t rows = this->get_buffer_length_() / stride;
+  const RamWindow &window = this->update_window_;
+  for (uint16_t y = window.y_start; y <= window.y_end; y++) {
+    const uint8_t *current = this->transfer_buffer_ + y * stride;
+    const uint8_t *previous = this->previous_buffer_ + y * stride;
+    uint32_t *region_row = this->churn_ + (y * CHURN_GRID / rows) * CHURN_GRID;
+    for (uint16_t x = window.x_start; x <= window.x_end; x++) {
+      const uint8_t flipped = current[x] ^ previous[x];
+      if (flipped != 0)
+        region_row[x * CHURN_GRID / stride] += __builtin_popcount(flipped);
+    }
+  }
+}
+
+bool CrowPanelEPaperBase::find_hot_regions_(RamWindow *window) {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t rows = this->get_buffer_length_() / stride;
+  const uint32_t region_pixels = (stride * 8u / CHURN_GRID) * (rows / CHURN_GRID);
+  const uint32_t threshold = std::max<uint32_t>(1, this->churn_threshold_ * region_pixels);
+
+  bool found = false;
+  for (uint8_t ry = 0; ry < CHURN_GRID; ry++) {
+    for (uint8_t rx = 0; rx < CHURN_GRID; rx++) {
+      if (this->churn_[ry * CHURN_GRID + rx] < threshold)
+        continue;
+      const uint16_t x_start = rx * stride / CHURN_GRID;
+      const uint16_t x_end = (rx + 1) * stride / CHURN_GRID - 1;
+      const uint16_t y_start = ry * rows / CHURN_GRID;
+      const uint16_t y_end = (ry + 1) * rows / CHURN_GRID - 1;
+      if (!found) {
+        *window = {x_start, x_end, y_start, y_end};
+        found = true;
+        continue;
+      }
+      window->x_start = std::min(window->x_start, x_start);
+      window->x_end = std::max(window->x_end, x_end);
+      window->y_start = std::min(window->y_start, y_start);
+      window->y_end = std::max(window->y_end, y_end);
+    }
+  }
+  return found;
+}
+
+void CrowPanelEPaperBase::reset_churn_(const RamWindow &window) {
+  const uint16_t stride = this->get_row_stride_();
+  const uint16_t rows = this->get_buffer_length_() / stride;
+  for (uint8_t ry = window.y_start * CHURN_GRID / rows; ry <= window.y_end * CHURN_GRID / rows; ry++) {
+    for (uint8_t rx = window.x_start * CHURN_GRID / stride; rx <= window.x_end * CHURN_GRID / stride; rx++)
+      this->churn_[ry * CHURN_GRID + rx] = 0;
+  }
+}
+
+// ========================================================
+// CrowPanelEPaperBase Implementation - Fast Refresh
+// ========================================================
+
+UpdateMode CrowPanelEPaperBase::resolve_fast_mode_() {
+  // Short waveforms leave too much ghosting when the ink is cold and slow.
+  if (!std::isnan(this->temperature_) && this->temperature_ < 10.0f) {
+    ESP_LOGD(TAG, "%.1f°C is too cold for a fast refresh, using FULL", this->temperature_);
+    return UpdateMode::FULL;
+  }
+  return UpdateMode::FAST;
+}
+
+const uint8_t *CrowPanelEPaperBase::fast_refresh_sequence_() {
+  if (this->fast_lut_ != nullptr) {
+    this->write_fast_lut_();
+    return fast_refresh_sequence.data();
+  }
+
+  // The warmer it is, the further we can push the waveform.
+  const bool cold = std::isnan(this->temperature_) || this->temperature_ < 20.0f;
+  if (this->has_secondary_controller_())
+    return cold ? fast_otp_sequence_cascade_cold.data() : fast_otp_sequence_cascade_warm.data();
+  return cold ? fast_otp_sequence_cold.data() : fast_otp_sequence_warm.data();
+}
+
+void CrowPanelEPaperBase::write_fast_lut_() {
+  const uint8_t targets[] = {CMD_TARGET_PRIMARY, CMD_TARGET_SECONDARY};
+  const uint8_t target_count = this->has_secondary_controller_() ? 2 : 1;
+  for (uint8_t t = 0; t < target_count; t++) {
+    this->transfer_array_(CMD_WRITE_LUT | targets[t], this->fast_lut_, LUT_SIZE);
+  }
+  if (this->fast_lut_len_ < LUT_SIZE_WITH_VOLTAGES)
+    return;
+
+  // The voltages are shared, the primary controller drives them.
+  const uint8_t *voltages = this->fast_lut_ + LUT_SIZE;
+  this->transfer_(CMD_END_OPTION, voltages[0]);
+  this->transfer_(CMD_GATE_VOLTAGE, voltages[1]);
+  this->transfer_array_(CMD_SOURCE_VOLTAGE, voltages + 2, 3);
+  this->transfer_(CMD_WRITE_VCOM, voltages[5]);
+}
+
+void CrowPanelEPaperBase::dump_update_config_() {
+  if (this->min_update_interval_ != 0)
+    ESP_LOGCONFIG(TAG, "  Min Update Interval: %u ms", this->min_update_interval_);
+  if (this->max_refreshes_per_hour_ != 0)
+    ESP_LOGCONFIG(TAG, "  Max Refreshes Per Hour: %u", this->max_refreshes_per_hour_);
+  if (this->bus_ != nullptr)
+    ESP_LOGCONFIG(TAG, "  Bus: shared");
+  if (this->busy_pin_ != nullptr && !this->busy_interrupt_)
+    ESP_LOGCONFIG(TAG, "  Busy Pin: polled, it has no interrupt");
+  if (this->has_forced_update_mode_)
+    ESP_LOGCONFIG(TAG, "  Update Mode: %s", update_mode_to_string(this->force_update_mode_));
+  if (this->fast_lut_ != nullptr)
+    ESP_LOGCONFIG(TAG, "  Fast LUT: custom, %zu bytes", this->fast_lut_len_);
+  if (this->churn_threshold_ > 0.0f) {
+    ESP_LOGCONFIG(TAG, "  Full Update Churn: %.0f%%%s", this->churn_threshold_ * 100.0f,
+                  this->regional_full_update_ ? " (regional)" : "");
+  } else {
+    ESP_LOGCONFIG(TAG, "  Full Update Every: %u", this->full_update_every_);
+  }
+  if (this->full_update_max_interval_ != 0)
+    ESP_LOGCONFIG(TAG, "  Full Update Max Interval: %u s", this->full_update_max_interval_ / 1000u);
+#ifdef USE_TIME
+  if (this->quiet_clock_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Quiet Hours: %02u:%02u-%02u:%02u", this->quiet_start_ / 60u, this->quiet_start_ % 60u,
+                  this->quiet_end_ / 60u, this->quiet_end_ % 60u);
+  }
+#endif
+  ESP_LOGCONFIG(TAG, "  Double Buffered: %s", YESNO(this->transfer_buffer_ != this->buffer_));
+  ESP_LOGCONFIG(TAG, "  Page Cache: %s", YESNO(this->page_cache_));
+  if (this->background_writer_)
+    ESP_LOGCONFIG(TAG, "  Background Layer: %s", this->background_ != nullptr ? "retained" : "redrawn");
+  if (!this->watched_.empty())
+    ESP_LOGCONFIG(TAG, "  Watched Sources: %u", static_cast<unsigned>(this->watched_.size()));
+  ESP_LOGCONFIG(TAG, "  Sleep Between Updates: %s", YESNO(this->sleep_between_updates_));
+  ESP_LOGCONFIG(TAG, "  Send Budget: %u us per loop", this->send_budget_us_);
+  ESP_LOGCONFIG(TAG, "  Send Rate: %.1f kB/s measured, %.1f kB/s last upload", this->send_rate_ * 1000.0f,
+                this->upload_throughput_);
+  for (uint8_t i = 0; i < UPDATE_PHASE_COUNT; i++) {
+    const PhaseStats &stats = this->phase_stats_[i];
+    if (stats.count() == 0)
+      continue;
+    ESP_LOGCONFIG(TAG, "  %s: min %.1f, avg %.1f, max %.1f, p95 %.1f ms over %u updates", PHASE_NAMES[i],
+                  stats.min() / 1000.0f, stats.avg() / 1000.0f, stats.max() / 1000.0f, stats.p95() / 1000.0f,
+                  stats.count());
+  }
+}
+
 uint32_t CrowPanelEPaperBase::get_buffer_length_() {
   return this->get_width_internal() * this->get_height_internal() / 8u;
 }
@@ -491,7 +1484,7 @@ int CrowPanelEPaper::get_height_internal() {
 
 void CrowPanelEPaper::fill(Color color) {
   const uint8_t fill = color.is_on() ? 0x00 : 0xFF;
-  ESP_LOGD(TAG, "Filling buffer with %s", color.is_on() ? "BLACK" : "WHITE");
+  ESP_LOGV(TAG, "Filling buffer with %s", color.is_on() ? "BLACK" : "WHITE");
   
   if (this->get_buffer_length_() == 0 || this->buffer_ == nullptr) {
     ESP_LOGE(TAG, "ERROR: Buffer not initialized");
@@ -500,42 +1493,374 @@ void CrowPanelEPaper::fill(Color color) {
   std::memset(this->buffer_, fill, this->get_buffer_length_());
 }
 
-void CrowPanelEPaper::draw_absolute_pixel_internal(int x, int y, Color color) {
-  int rotated_x, rotated_y;
-  int native_w = this->get_native_width_();
-  int native_h = this->get_native_height_();
+void HOT CrowPanelEPaper::draw_absolute_pixel_internal(int x, int y, Color color) {
+  // Rotation, bounds and geometry are folded into the writer chosen in set_rotation().
+  this->pixel_writer_(this->buffer_, x, y, color.is_on());
+}
 
-  // Apply rotation.
-  if (!this->calculate_rotated_coords_(x, y, native_w, native_h, &rotated_x, &rotated_y)) {
-    return; // Coordinates out of bounds after rotation
+void CrowPanelEPaper::line(int x1, int y1, int x2, int y2, Color color) {
+  if (y1 == y2) {
+    this->horizontal_line(std::min(x1, x2), y1, std::abs(x2 - x1) + 1, color);
+  } else if (x1 == x2) {
+    this->vertical_line(x1, std::min(y1, y2), std::abs(y2 - y1) + 1, color);
+  } else {
+    display::Display::line(x1, y1, x2, y2, color);
   }
+}
+
+void CrowPanelEPaper::horizontal_line(int x, int y, int width, Color color) {
+  this->filled_rectangle(x, y, width, 1, color);
+}
+
+void CrowPanelEPaper::vertical_line(int x, int y, int height, Color color) {
+  this->filled_rectangle(x, y, 1, height, color);
+}
 
-  rotated_x = native_w - 1 - rotated_x;
+void CrowPanelEPaper::rectangle(int x1, int y1, int width, int height, Color color) {
+  this->horizontal_line(x1, y1, width, color);
+  this->horizontal_line(x1, y1 + height - 1, width, color);
+  this->vertical_line(x1, y1, height, color);
+  this->vertical_line(x1 + width - 1, y1, height, color);
+}
 
-  // Use the directly rotated coordinates for buffer calculation
-  // Check bounds using the correctly rotated coordinates
-  if (rotated_x < 0 || rotated_x >= native_w || rotated_y < 0 || rotated_y >= native_h) {
-     // Should not happen if calculate_rotated_coords_ includes a check, but good practice.
-     return;
+void HOT CrowPanelEPaper::filled_rectangle(int x1, int y1, int width, int height, Color color) {
+  // Clip to the screen and to the active clipping region, in logical coordinates.
+  int x2 = x1 + width - 1;
+  int y2 = y1 + height - 1;
+  x1 = std::max(x1, 0);
+  y1 = std::max(y1, 0);
+  x2 = std::min(x2, this->get_width_internal() - 1);
+  y2 = std::min(y2, this->get_height_internal() - 1);
+  const display::Rect clip = this->get_clipping();
+  if (clip.is_set()) {
+    x1 = std::max<int>(x1, clip.x);
+    y1 = std::max<int>(y1, clip.y);
+    x2 = std::min<int>(x2, clip.x + clip.w - 1);
+    y2 = std::min<int>(y2, clip.y + clip.h - 1);
   }
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  // Any rotation maps an axis-aligned rectangle onto another one in native space.
+  int nx1, ny1, nx2, ny2;
+  this->map_to_native_(x1, y1, &nx1, &ny1);
+  this->map_to_native_(x2, y2, &nx2, &ny2);
+  if (nx1 > nx2)
+    std::swap(nx1, nx2);
+  if (ny1 > ny2)
+    std::swap(ny1, ny2);
+  this->fill_native_rect_(nx1, ny1, nx2, ny2, color.is_on());
+}
 
-  // Calculate buffer offset using rotated coordinates
-  const uint32_t byte_offset = (rotated_y * native_w + rotated_x) / 8u;
-  const uint8_t bit_offset = 7 - (rotated_x % 8); // MSB is leftmost pixel
+// Sets or clears an inclusive rectangle of one plane.
+static void HOT fill_plane_rect(uint8_t *plane, uint16_t stride, int x1, int y1, int x2, int y2, bool on) {
+  const int first = x1 >> 3;
+  const int last = x2 >> 3;
+  // MSB is the leftmost pixel of each byte.
+  uint8_t head = 0xFF >> (x1 & 7);
+  const uint8_t tail = 0xFF << (7 - (x2 & 7));
+  if (first == last)
+    head &= tail;
+  // On is black, which is a cleared bit.
+  const uint8_t value = on ? 0x00 : 0xFF;
+
+  for (int y = y1; y <= y2; y++) {
+    uint8_t *row = plane + y * stride;
+    row[first] = on ? (row[first] & ~head) : (row[first] | head);
+    if (first == last)
+      continue;
+    if (last - first > 1)
+      memset(row + first + 1, value, last - first - 1);
+    row[last] = on ? (row[last] & ~tail) : (row[last] | tail);
+  }
+}
 
-  // Check buffer bounds
-  if (byte_offset >= this->get_buffer_length_()) {
-    // ESP_LOGE(TAG, "ERROR: Attempt to write outside buffer (%d, %d) -> rotated (%d, %d) -> byte %u >= %u", x, y, rotated_x, rotated_y, byte_offset, this->get_buffer_length_());
-    return; // Error: write outside buffer
+void HOT CrowPanelEPaper::fill_native_rect_(int x1, int y1, int x2, int y2, bool on) {
+  const uint16_t stride = this->get_row_stride_();
+  for (uint8_t p = 0; p < this->plane_count_; p++) {
+    const NativePlane &plane = this->planes_[p];
+    const int plane_x1 = std::max<int>(x1, plane.x_start) - plane.x_start;
+    const int plane_x2 = std::min<int>(x2, plane.x_end) - plane.x_start;
+    if (plane_x1 <= plane_x2)
+      fill_plane_rect(this->buffer_ + plane.offset, stride, plane_x1, y1, plane_x2, y2, on);
   }
+}
 
-  // Write pixel
-  // Since this is an EPD, on is black and off is white.
-  if (color.is_on()) {
-    this->buffer_[byte_offset] &= ~(1 << bit_offset);
-  } else {
-    this->buffer_[byte_offset] |= (1 << bit_offset);
+// Reads `count` (1-8) bits starting at bit `bit` of a packed MSB-first bitstream.
+static inline uint8_t read_bits(const uint8_t *data, uint32_t bit, uint8_t count) {
+  const uint8_t *src = data + (bit >> 3);
+  const uint8_t shift = bit & 7;
+  uint16_t window = src[0] << 8;
+  if (shift + count > 8)
+    window |= src[1];  // Only touch the next byte when the bits actually straddle it
+  return static_cast<uint16_t>(window << shift) >> (16 - count);
+}
+
+static inline uint8_t reverse_bits(uint8_t value) {
+  value = (value & 0xF0) >> 4 | (value & 0x0F) << 4;
+  value = (value & 0xCC) >> 2 | (value & 0x33) << 2;
+  value = (value & 0xAA) >> 1 | (value & 0x55) << 1;
+  return value;
+}
+
+void HOT CrowPanelEPaper::blit_bitmap_(int x, int y, int width, int height, const uint8_t *data, bool on) {
+  const int logical_w = this->get_width_internal();
+  const int logical_h = this->get_height_internal();
+  // Clip the bitmap against the screen.
+  const int col_first = std::max(0, -x);
+  const int col_last = std::min(width, logical_w - x) - 1;
+  const int row_first = std::max(0, -y);
+  const int row_last = std::min(height, logical_h - y) - 1;
+  if (col_first > col_last || row_first > row_last)
+    return;
+
+  if (this->rotation_ == display::DISPLAY_ROTATION_90_DEGREES ||
+      this->rotation_ == display::DISPLAY_ROTATION_270_DEGREES) {
+    // Logical rows run along native columns here, there is nothing to gain from whole bytes.
+    for (int row = row_first; row <= row_last; row++) {
+      uint32_t bit = row * width + col_first;
+      for (int col = col_first; col <= col_last; col++, bit++) {
+        if (data[bit >> 3] & (0x80 >> (bit & 7)))
+          this->pixel_writer_(this->buffer_, x + col, y + row, on);
+      }
+    }
+    return;
+  }
+
+  // At 0 and 180 degrees a logical row is (part of) a native row. At 0 degrees the native X axis
+  // runs the other way, so the bits are mirrored on the way in.
+  const bool mirrored = this->rotation_ != display::DISPLAY_ROTATION_180_DEGREES;
+  const uint16_t stride = this->get_row_stride_();
+  const int count = col_last - col_first + 1;
+  for (int row = row_first; row <= row_last; row++) {
+    int native_x, native_y, native_x_end, unused;
+    this->map_to_native_(x + col_first, y + row, &native_x, &native_y);
+    this->map_to_native_(x + col_last, y + row, &native_x_end, &unused);
+    if (mirrored)
+      native_x = native_x_end;  // Leftmost native pixel is the last source pixel
+    const uint32_t row_bit = row * width + col_first;
+
+    for (uint8_t p = 0; p < this->plane_count_; p++) {
+      // The part of native pixels [native_x, native_x + count) stored in this plane
+      const NativePlane &plane = this->planes_[p];
+      const int begin = std::max<int>(native_x, plane.x_start) - native_x;
+      const int end = std::min<int>(native_x + count - 1, plane.x_end) + 1 - native_x;
+      uint8_t *dst = this->buffer_ + plane.offset + native_y * stride;
+      const int plane_x = native_x - plane.x_start;
+
+      int done = begin;
+      while (done < end) {
+        const uint8_t offset = (plane_x + done) & 7;
+        const uint8_t n = std::min(8 - offset, end - done);
+        uint8_t bits;
+        if (mirrored) {
+          // Native pixels [done, done + n) come from source pixels (count - done - n, count - done].
+          bits = reverse_bits(read_bits(data, row_bit + count - done - n, n)) >> (8 - n);
+        } else {
+          bits = read_bits(data, row_bit + done, n);
+        }
+        const uint8_t mask = bits << (8 - offset - n);
+        uint8_t &byte = dst[(plane_x + done) >> 3];
+        // On is black, which is a cleared bit.
+        byte = on ? (byte & ~mask) : (byte | mask);
+        done += n;
+      }
+    }
+  }
+}
+
+#ifdef USE_CROWPANEL_EPAPER_FONT
+// print() below reads the font component's glyph tables, which are not a public API and have
+// changed between ESPHome releases. Fail here rather than somewhere in the middle of it.
+template<typename F, typename = void> struct has_glyph_tables : std::false_type {};
+template<typename F>
+struct has_glyph_tables<
+    F, std::void_t<decltype(std::declval<F &>().match_next_glyph(std::declval<const uint8_t *>(), std::declval<int *>())),
+                   decltype(std::declval<F &>().get_bpp()), decltype(std::declval<F &>().get_height()),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->data),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->advance),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->offset_x),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->offset_y),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->width),
+                   decltype(std::declval<F &>().get_glyphs()[0].get_glyph_data()->height)>> : std::true_type {};
+static_assert(has_glyph_tables<font::Font>::value,
+              "font::Font no longer has the glyph tables CrowPanelEPaper::print() reads, it needs "
+              "updating for this ESPHome version");
+
+void CrowPanelEPaper::print(int x, int y, font::Font *font, Color color, display::TextAlign align, const char *text,
+                            Color background) {
+  if (font->get_bpp() != 1 || this->get_clipping().is_set()) {
+    display::Display::print(x, y, font, color, align, text, background);
+    return;
+  }
+
+  int x_start, y_start, width, height;
+  this->get_text_bounds(x, y, text, font, align, &x_start, &y_start, &width, &height);
+
+  // Same traversal as font::Font::print(), but each glyph is blitted instead of drawn pixel by pixel.
+  const bool on = color.is_on();
+  const auto &glyphs = font->get_glyphs();
+  int x_at = x_start;
+  int i = 0;
+  while (text[i] != '\0') {
+    int match_length;
+    int glyph_n = font->match_next_glyph(reinterpret_cast<const uint8_t *>(text) + i, &match_length);
+    if (glyph_n < 0) {
+      // Unknown char, draw a placeholder like the font does
+      ESP_LOGW(TAG, "Encountered character without representation in font: '%c'", text[i]);
+      if (!glyphs.empty()) {
+        const int glyph_width = glyphs[0].get_glyph_data()->advance;
+        this->filled_rectangle(x_at, y_start, glyph_width, font->get_height(), color);
+        x_at += glyph_width;
+      }
+      i++;
+      continue;
+    }
+    const font::GlyphData *glyph = glyphs[glyph_n].get_glyph_data();
+    this->blit_bitmap_(x_at + glyph->offset_x, y_start + glyph->offset_y, glyph->width, glyph->height, glyph->data,
+                       on);
+    x_at += glyph->advance;
+    i += match_length;
+  }
+}
+
+void CrowPanelEPaper::vprintf_panel_(int x, int y, font::Font *font, Color color, Color background,
+                                     display::TextAlign align, const char *format, va_list arg) {
+  char buffer[256];
+  int ret = vsnprintf(buffer, sizeof(buffer), format, arg);
+  if (ret > 0)
+    this->print(x, y, font, color, align, buffer, background);
+}
+
+void CrowPanelEPaper::printf(int x, int y, font::Font *font, Color color, Color background, display::TextAlign align,
+                             const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_panel_(x, y, font, color, background, align, format, arg);
+  va_end(arg);
+}
+
+void CrowPanelEPaper::printf(int x, int y, font::Font *font, Color color, display::TextAlign align,
+                             const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_panel_(x, y, font, color, display::COLOR_OFF, align, format, arg);
+  va_end(arg);
+}
+
+void CrowPanelEPaper::printf(int x, int y, font::Font *font, Color color, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_panel_(x, y, font, color, display::COLOR_OFF, display::TextAlign::TOP_LEFT, format, arg);
+  va_end(arg);
+}
+
+void CrowPanelEPaper::printf(int x, int y, font::Font *font, display::TextAlign align, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_panel_(x, y, font, display::COLOR_ON, display::COLOR_OFF, align, format, arg);
+  va_end(arg);
+}
+
+void CrowPanelEPaper::printf(int x, int y, font::Font *font, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_panel_(x, y, font, display::COLOR_ON, display::COLOR_OFF, display::TextAlign::TOP_LEFT, format, arg);
+  va_end(arg);
+}
+
+void CrowPanelEPaper::strftime(int x, int y, font::Font *font, Color color, display::TextAlign align,
+                               const char *format, ESPTime time) {
+  char buffer[64];
+  size_t ret = time.strftime(buffer, sizeof(buffer), format);
+  if (ret > 0)
+    this->print(x, y, font, color, align, buffer);
+}
+#endif  // USE_CROWPANEL_EPAPER_FONT
+
+// ========================================================
+// CrowPanelEPaper Implementation - Benchmark
+// ========================================================
+
+// Runs `body(i)` `ops` times and logs one machine-readable line. `pixels` is per op.
+template<typename F> static void benchmark_case(const char *name, uint32_t ops, uint32_t pixels, F &&body) {
+  const uint32_t start = micros();
+  for (uint32_t i = 0; i < ops; i++)
+    body(i);
+  const uint32_t elapsed = std::max<uint32_t>(1, micros() - start);
+  ESP_LOGI(TAG, "BENCH name=%s ops=%u ns_op=%u px_s=%.0f", name, ops,
+           static_cast<uint32_t>(static_cast<uint64_t>(elapsed) * 1000u / ops),
+           static_cast<double>(pixels) * ops * 1e6 / elapsed);
+  App.feed_wdt();
+}
+
+#ifdef USE_CROWPANEL_EPAPER_FONT
+void CrowPanelEPaper::run_benchmark(font::Font *font) {
+#else
+void CrowPanelEPaper::run_benchmark() {
+#endif
+  if (this->state_ != EpdState::IDLE || this->needs_update_) {
+    ESP_LOGW(TAG, "Benchmark skipped, the display is busy");
+    return;
   }
+  // The cases draw into the buffer, it gets the current frame back at the end.
+  const uint32_t buffer_length = this->get_buffer_length_();
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *saved_frame = allocator.allocate(buffer_length);
+  if (saved_frame == nullptr) {
+    ESP_LOGW(TAG, "Benchmark skipped, no memory to keep the frame");
+    return;
+  }
+  memcpy(saved_frame, this->buffer_, buffer_length);
+
+  // Rotated directly rather than with set_rotation(), which would drop the background and the
+  // page cache.
+  const display::DisplayRotation rotation = this->rotation_;
+  static const display::DisplayRotation ROTATIONS[] = {
+      display::DISPLAY_ROTATION_0_DEGREES, display::DISPLAY_ROTATION_90_DEGREES,
+      display::DISPLAY_ROTATION_180_DEGREES, display::DISPLAY_ROTATION_270_DEGREES};
+  static const char *const PIXEL_CASES[] = {"pixel_rot0", "pixel_rot90", "pixel_rot180", "pixel_rot270"};
+  for (uint8_t r = 0; r < 4; r++) {
+    this->rotation_ = ROTATIONS[r];
+    this->on_rotation_changed_();
+    const int w = this->get_width_internal();
+    const int h = this->get_height_internal();
+    benchmark_case(PIXEL_CASES[r], 20000, 1, [this, w, h](uint32_t i) {
+      this->draw_absolute_pixel_internal(i % w, (i / w) % h, (i & 1) ? display::COLOR_ON : display::COLOR_OFF);
+    });
+  }
+  this->rotation_ = rotation;
+  this->on_rotation_changed_();
+
+  const int w = this->get_width_internal();
+  const int h = this->get_height_internal();
+  benchmark_case("fill", 20, w * h, [this](uint32_t i) {
+    this->fill((i & 1) ? display::COLOR_ON : display::COLOR_OFF);
+  });
+  benchmark_case("horizontal_line", 1000, w, [this, w, h](uint32_t i) { this->horizontal_line(0, i % h, w); });
+  benchmark_case("vertical_line", 1000, h, [this, w, h](uint32_t i) { this->vertical_line(i % w, 0, h); });
+  benchmark_case("line", 200, std::max(w, h), [this, w, h](uint32_t i) { this->line(0, i % h, w - 1, h - 1 - i % h); });
+  benchmark_case("rectangle", 500, 4 * 100, [this, w, h](uint32_t i) {
+    this->rectangle(i % (w - 100), i % (h - 100), 100, 100);
+  });
+  benchmark_case("filled_rectangle", 500, 100 * 100, [this, w, h](uint32_t i) {
+    this->filled_rectangle(i % (w - 100), i % (h - 100), 100, 100);
+  });
+#ifdef USE_CROWPANEL_EPAPER_FONT
+  if (font != nullptr) {
+    static const char *const TEXT = "12:34 Temperature 21.5";
+    int x, y, text_w, text_h;
+    this->get_text_bounds(0, 0, TEXT, font, display::TextAlign::TOP_LEFT, &x, &y, &text_w, &text_h);
+    benchmark_case("print", 100, text_w * text_h, [this, font, h, text_h](uint32_t i) {
+      this->print(0, i % std::max(1, h - text_h), font, TEXT);
+    });
+  }
+#endif
+  if (this->page_ != nullptr || this->writer_.has_value())
+    benchmark_case("render", 5, w * h, [this](uint32_t) { this->draw_content_(); });
+
+  memcpy(this->buffer_, saved_frame, buffer_length);
+  allocator.deallocate(saved_frame, buffer_length);
 }
 
 // ========================================================
@@ -545,59 +1870,61 @@ void CrowPanelEPaper::draw_absolute_pixel_internal(int x, int y, Color color) {
 void CrowPanelEPaper4P2In::initialize() {
   ESP_LOGD(TAG, "Initializing CrowPanel 4.2in display");
 
-  // Send initialization sequence using the predefined commands
-  this->send_command_sequence_(display_start_sequence);
+  // Run the initialization sequence from loop(), then wait for the panel
+  this->start_sequence_(display_start_sequence.data(), EpdState::INIT_WAIT_BUSY);
 }
 
 void CrowPanelEPaper4P2In::prepare_for_update_(UpdateMode mode) {
-  if (mode == UpdateMode::FULL) {
+  // A fast update draws the whole frame like a full one, just with a shorter waveform.
+  if (mode != UpdateMode::PARTIAL) {
     ESP_LOGD(TAG, "Preparing for FULL update mode");
     
     // Set BorderWavefrom for full refresh
-    this->command(CMD_BORDER_WAVEFORM);
-    this->data(PARAM_BORDER_FULL);
+    this->transfer_(CMD_BORDER_WAVEFORM, PARAM_BORDER_FULL);
     
     // Additional display update control settings 
-    this->command(CMD_DISPLAY_UPDATE_CONTROL);
-    this->data(0x40);
-    this->data(PARAM_SEL_SINGLE_CHIP);
+    this->transfer_(CMD_DISPLAY_UPDATE_CONTROL, 0x40, PARAM_SEL_SINGLE_CHIP);
   } else {
     ESP_LOGD(TAG, "Preparing for PARTIAL update mode");
     
     // Set BorderWavefrom for partial refresh
-    this->command(CMD_BORDER_WAVEFORM);
-    this->data(PARAM_BORDER_PARTIAL);
+    this->transfer_(CMD_BORDER_WAVEFORM, PARAM_BORDER_PARTIAL);
     
     // Additional settings for partial update
-    this->command(CMD_DISPLAY_UPDATE_CONTROL);
-    this->data(0x00);
-    this->data(PARAM_SEL_SINGLE_CHIP);
+    this->transfer_(CMD_DISPLAY_UPDATE_CONTROL, 0x00, PARAM_SEL_SINGLE_CHIP);
   }
 }
 
 void CrowPanelEPaper4P2In::display() {
   ESP_LOGD(TAG, "E-Paper display refresh starting");
   // Set the display mode based on update type
-  UpdateMode mode = this->is_full_update_ ? UpdateMode::FULL : UpdateMode::PARTIAL;
-  this->prepare_for_update_(mode);
-  // Reset RAM address counters before writing data
-  this->command(CMD_SET_X_COUNTER);
-  this->data(0x00);
-  this->command(CMD_SET_Y_COUNTER);
-  this->data(0x00);
-  this->data(0x00);
-  // Send command to write to BLACK/WHITE RAM
-  this->command(CMD_WRITE_RAM);
-  // Start non-blocking data transfer (handled in state machine)
-  this->start_data_();
-  this->data_send_index_ = 0;
+  this->prepare_for_update_(this->update_mode_);
+  // Restrict the RAM area to what changed (or the whole panel)
+  this->prepare_window_();
+  const RamWindow &window = this->update_window_;
+  this->transfer_(CMD_SET_X_ADDR, window.x_start, window.x_end);
+  this->transfer_(CMD_SET_Y_ADDR, window.y_start & 0xFF, window.y_start >> 8, window.y_end & 0xFF, window.y_end >> 8);
+  // Write to BLACK/WHITE RAM, non-blocking data transfer is handled in the state machine
+  this->begin_ram_write_(CMD_WRITE_RAM);
+}
+
+void CrowPanelEPaper4P2In::start_ram_write_(uint8_t command) {
+  const RamWindow &window = this->update_window_;
+  // Reset RAM address counters to the window's origin before writing data
+  this->transfer_(CMD_SET_X_COUNTER, window.x_start);
+  this->transfer_(CMD_SET_Y_COUNTER, window.y_start & 0xFF, window.y_start >> 8);
+  this->start_write_(command);
+}
+
+const uint8_t *CrowPanelEPaper4P2In::wake_sequence_() {
+  return display_wake_sequence.data();
 }
 
 void CrowPanelEPaper4P2In::deep_sleep() {
   ESP_LOGD(TAG, "Entering deep sleep mode");
   
   // Send deep sleep sequence
-  this->send_command_sequence_(display_stop_sequence);
+  this->send_command_sequence_(display_stop_sequence.data());
 }
 
 void CrowPanelEPaper4P2In::dump_config() {
@@ -606,6 +1933,8 @@ void CrowPanelEPaper4P2In::dump_config() {
   LOG_PIN("  Reset Pin: ", this->reset_pin_);
   LOG_PIN("  DC Pin: ", this->dc_pin_);
   LOG_PIN("  Busy Pin: ", this->busy_pin_);
+  this->transport_->dump_config();
+  this->dump_update_config_();
   LOG_UPDATE_INTERVAL(this);
 }
 
@@ -620,66 +1949,58 @@ void CrowPanelEPaper4P2In::dump_config() {
 void CrowPanelEPaper5P79In::initialize() {
   ESP_LOGD(TAG, "Initializing CrowPanel 5.79in display");
 
-  // Send initialization sequence using the predefined commands
-  this->send_command_sequence_(display_start_sequence_5p79in);
+  // Run the initialization sequence from loop(), then wait for the panel
+  this->start_sequence_(display_start_sequence_5p79in.data(), EpdState::INIT_WAIT_BUSY);
 }
 
 void CrowPanelEPaper5P79In::prepare_for_update_(UpdateMode mode) {
-  if (mode == UpdateMode::FULL) {
+  if (mode != UpdateMode::PARTIAL) {
     ESP_LOGD(TAG, "Preparing for FULL update mode");
     
     // Set BorderWavefrom for full refresh
-    this->command(CMD_BORDER_WAVEFORM);
-    this->data(PARAM_BORDER_FULL);
+    this->transfer_(CMD_BORDER_WAVEFORM, PARAM_BORDER_FULL);
     
     // Additional display update control settings 
-    this->command(CMD_DISPLAY_UPDATE_CONTROL);
-    this->data(0x40);
-    this->data(PARAM_SEL_CASCADE);
+    this->transfer_(CMD_DISPLAY_UPDATE_CONTROL, 0x40, PARAM_SEL_CASCADE);
   } else {
     ESP_LOGD(TAG, "Preparing for PARTIAL update mode");
     
     // Set BorderWavefrom for partial refresh
-    this->command(CMD_BORDER_WAVEFORM);
-    this->data(PARAM_BORDER_PARTIAL);
+    this->transfer_(CMD_BORDER_WAVEFORM, PARAM_BORDER_PARTIAL);
     
     // Additional settings for partial update
-    this->command(CMD_DISPLAY_UPDATE_CONTROL);
-    this->data(0x00);
-    this->data(PARAM_SEL_CASCADE);
+    this->transfer_(CMD_DISPLAY_UPDATE_CONTROL, 0x00, PARAM_SEL_CASCADE);
   }
 }
 
 void CrowPanelEPaper5P79In::display() {
   ESP_LOGD(TAG, "E-Paper display refresh starting");
   // Set the display mode based on update type
-  UpdateMode mode = this->is_full_update_ ? UpdateMode::FULL : UpdateMode::PARTIAL;
-  this->prepare_for_update_(mode);
-  // Reset RAM address counters before writing data
-  // Primary controller (start from top-left)
-  this->command(CMD_SET_X_COUNTER | CMD_TARGET_PRIMARY);
-  this->data(0x00);
-  this->command(CMD_SET_Y_COUNTER| CMD_TARGET_PRIMARY);
-  this->data(0x00);
-  this->data(0x00);
-  // Secondary controller (start from top-right)
-  this->command(CMD_SET_X_COUNTER | CMD_TARGET_SECONDARY);
-  this->data(0x31); // 49b -> 400px
-  this->command(CMD_SET_Y_COUNTER | CMD_TARGET_SECONDARY);
-  this->data(0x00);
-  this->data(0x00);
-
-  // Start by filling the primary controller's RAM
-  this->cascade_state_ = EpdCascadeState::PRIMARY;
+  this->prepare_for_update_(this->update_mode_);
+  // Only the rows are narrowed here. Both controllers still get their full width, the
+  // secondary one runs right to left and shares the middle column with the primary.
+  this->prepare_window_();
+  this->prepare_controller_windows_();
+  RamWindow window;
+  if (this->controller_window_(EpdCascadeState::PRIMARY, &window))
+    this->set_controller_window_(EpdCascadeState::PRIMARY);
+  if (this->controller_window_(EpdCascadeState::SECONDARY, &window))
+    this->set_controller_window_(EpdCascadeState::SECONDARY);
+
+  // Start by filling the primary controller's RAM, unless it has nothing to do
+  this->cascade_state_ = this->first_controller_();
   this->data_send_index_ = 0;
-  this->data_send_x_offset_ = 0;
-  this->command(CMD_WRITE_RAM | CMD_TARGET_PRIMARY);
-  this->start_data_();
+  this->begin_ram_write_(CMD_WRITE_RAM);
 }
 
-void CrowPanelEPaper5P79In::update_send_data_(uint32_t now) {
-  // We can easily send 2 rows of data without exceeding the 30ms limit.
-  constexpr size_t chunk_size = 2u * (NATIVE_WIDTH_5P79IN / 2u);
+RamWindow CrowPanelEPaper5P79In::controller_area_(EpdCascadeState controller) {
+  const uint16_t first = this->controller_first_row_(controller);
+  const uint16_t last = first + NATIVE_HEIGHT_5P79IN - 1;
+  if (this->split_layout_) {
+    // Each controller has its own plane, stacked in the buffer.
+    return {0, Geometry5P79In::SPLIT_STRIDE - 1, first, last};
+  }
+
   constexpr uint16_t width_bytes = NATIVE_WIDTH_5P79IN / 8u;
   // It's important to round up here!
   constexpr uint16_t x_offset_end = (width_bytes + 1u) / 2u;
@@ -690,64 +2011,145 @@ void CrowPanelEPaper5P79In::update_send_data_(uint32_t now) {
   // with two controllers, each with its own buffer. Worse, they even have an overlap in the middle.
   // Luckily for us, we can just write the 8-bit overlap data to both controllers and it will work
   // fine. That's why the rounding is important above.
-  //
-  // The rest is a pretty straight-forward 2D traversal of the buffer. We do it in 2 dimensions
-  // because the buffer's layout would force us to switch controllers right in the middle of a row,
-  // which is not ideal. Instead we first write the left half of the buffer to the primary
-  // controller, then switch to the secondary controller and write the right half of the buffer.
-
-  // For the secondary controller, read from the right half of the buffer.
-  uint16_t x_start = (this->cascade_state_ == EpdCascadeState::PRIMARY) ? 0 : x_offset_start;
-
-  bool done = false;
-  for (size_t i = 0; i < chunk_size; ++i) {
-    size_t index = this->data_send_index_ * width_bytes + x_start + this->data_send_x_offset_;
-    assert(index < this->get_buffer_length_());
-    this->write_byte_soft_spi(this->buffer_[index]);
-
-    ++this->data_send_x_offset_;
-    if (this->data_send_x_offset_ >= x_offset_end) {
-      this->data_send_x_offset_ = 0u;
-      ++this->data_send_index_;
-      if (this->data_send_index_ >= this->get_native_height_()) {
-        done = true;
-        break;
+  if (controller == EpdCascadeState::PRIMARY)
+    return {0, x_offset_end - 1, first, last};
+  return {x_offset_start, width_bytes - 1, first, last};
+}
+
+void CrowPanelEPaper5P79In::prepare_controller_windows_() {
+  const RamWindow &update = this->update_window_;
+  const bool narrow = !this->is_full_update_ && this->previous_valid_ && this->previous_buffer_ != nullptr;
+  bool any = false;
+  for (auto controller : {EpdCascadeState::PRIMARY, EpdCascadeState::SECONDARY}) {
+    const uint8_t index = static_cast<uint8_t>(controller);
+    RamWindow &window = this->controller_windows_[index];
+    window = this->controller_area_(controller);
+    bool active = update.y_end >= window.y_start && update.y_start <= window.y_end;
+    if (active) {
+      window.y_start = std::max(window.y_start, update.y_start);
+      window.y_end = std::min(window.y_end, update.y_end);
+    }
+    if (active && narrow) {
+      // A clock in one corner only touches one controller, the other one can sit this out.
+      RamWindow dirty = window;
+      active = this->narrow_dirty_rows_(&dirty);
+      const RamWindow &clean = this->clean_window_;
+      if (this->invert_old_image_ && clean.x_end >= window.x_start && clean.x_start <= window.x_end &&
+          clean.y_end >= window.y_start && clean.y_start <= window.y_end) {
+        // Regions being cleaned go out as well, changed or not.
+        const uint16_t clean_start = std::max(clean.y_start, window.y_start);
+        const uint16_t clean_end = std::min(clean.y_end, window.y_end);
+        dirty.y_start = active ? std::min(dirty.y_start, clean_start) : clean_start;
+        dirty.y_end = active ? std::max(dirty.y_end, clean_end) : clean_end;
+        active = true;
       }
+      if (active)
+        window = dirty;
+    }
+    this->controller_active_[index] = active;
+    any |= active;
+  }
+
+  if (!any) {
+    // Nothing to narrow down to, send the whole window like the single controller models do.
+    for (auto controller : {EpdCascadeState::PRIMARY, EpdCascadeState::SECONDARY}) {
+      const uint8_t index = static_cast<uint8_t>(controller);
+      this->controller_windows_[index] = this->controller_area_(controller);
+      this->controller_active_[index] = true;
     }
   }
-  // Still writing data...
-  if (!done) return;
+  if (!this->controller_active_[static_cast<uint8_t>(EpdCascadeState::PRIMARY)]) {
+    ESP_LOGD(TAG, "Primary controller unchanged, skipping it");
+  } else if (!this->controller_active_[static_cast<uint8_t>(EpdCascadeState::SECONDARY)]) {
+    ESP_LOGD(TAG, "Secondary controller unchanged, skipping it");
+  }
+}
+
+bool CrowPanelEPaper5P79In::controller_window_(EpdCascadeState controller, RamWindow *window) {
+  const uint8_t index = static_cast<uint8_t>(controller);
+  *window = this->controller_windows_[index];
+  return this->controller_active_[index];
+}
+
+uint16_t CrowPanelEPaper5P79In::controller_first_row_(EpdCascadeState controller) {
+  if (this->split_layout_ && controller == EpdCascadeState::SECONDARY)
+    return NATIVE_HEIGHT_5P79IN;
+  return 0;
+}
+
+EpdCascadeState CrowPanelEPaper5P79In::first_controller_() {
+  RamWindow window;
+  return this->controller_window_(EpdCascadeState::PRIMARY, &window) ? EpdCascadeState::PRIMARY
+                                                                      : EpdCascadeState::SECONDARY;
+}
+
+void CrowPanelEPaper5P79In::set_controller_window_(EpdCascadeState controller) {
+  RamWindow window;
+  this->controller_window_(controller, &window);
+  const uint16_t y_start = window.y_start - this->controller_first_row_(controller);
+  const uint16_t y_end = window.y_end - this->controller_first_row_(controller);
+  const uint8_t target = controller == EpdCascadeState::PRIMARY ? CMD_TARGET_PRIMARY : CMD_TARGET_SECONDARY;
+  this->transfer_(CMD_SET_Y_ADDR | target, y_start & 0xFF, y_start >> 8, y_end & 0xFF, y_end >> 8);
+}
+
+void CrowPanelEPaper5P79In::start_ram_write_(uint8_t command) {
+  RamWindow window;
+  this->controller_window_(this->cascade_state_, &window);
+  const uint16_t y_start = window.y_start - this->controller_first_row_(this->cascade_state_);
+  const uint8_t target = this->cascade_state_ == EpdCascadeState::PRIMARY ? CMD_TARGET_PRIMARY : CMD_TARGET_SECONDARY;
+  // Reset RAM address counters before writing data. The primary controller starts from the
+  // top-left, the secondary one from the top-right.
+  const uint8_t x_start = this->cascade_state_ == EpdCascadeState::PRIMARY ? 0x00 : 0x31;  // 49b -> 400px
+  this->transfer_(CMD_SET_X_COUNTER | target, x_start);
+  this->transfer_(CMD_SET_Y_COUNTER | target, y_start & 0xFF, y_start >> 8);
+  this->start_write_(command | target);
+}
+
+void CrowPanelEPaper5P79In::update_send_data_(uint32_t now) {
+  // We first write the left half of the buffer to the primary controller, then switch to the
+  // secondary controller and write the right half of the buffer. This way we never have to switch
+  // controllers in the middle of a row.
+  RamWindow window;
+  this->controller_window_(this->cascade_state_, &window);
+  if (!this->send_window_budgeted_(window))
+    return;  // Still writing data...
 
   // The current transfer is done.
   this->end_data_();
-  if (this->cascade_state_ == EpdCascadeState::PRIMARY) {
-    // We finished the primary controller's data, let's switch to the secondary controller.
+  if (this->cascade_state_ == EpdCascadeState::PRIMARY &&
+      this->controller_window_(EpdCascadeState::SECONDARY, &window)) {
+    // Let's switch to the secondary controller, same RAM.
     this->cascade_state_ = EpdCascadeState::SECONDARY;
     this->data_send_index_ = 0;
-    this->data_send_x_offset_ = 0;
-    this->command(CMD_WRITE_RAM | CMD_TARGET_SECONDARY);
-    this->start_data_();
+    this->begin_ram_write_(this->ram_command_());
     return;
   }
 
-  // We're done with both controllers.
-  this->state_ = EpdState::UPDATE_REFRESH;
-  this->state_start_time_ = now;
+  // We're done with both controllers, the next pass starts with the first one again.
+  this->cascade_state_ = this->first_controller_();
+  this->finish_upload_pass_(now);
+}
+
+const uint8_t *CrowPanelEPaper5P79In::wake_sequence_() {
+  return display_wake_sequence_5p79in.data();
 }
 
 void CrowPanelEPaper5P79In::deep_sleep() {
   ESP_LOGD(TAG, "Entering deep sleep mode");
   
   // Send deep sleep sequence
-  this->send_command_sequence_(display_stop_sequence);
+  this->send_command_sequence_(display_stop_sequence.data());
 }
 
 void CrowPanelEPaper5P79In::dump_config() {
   LOG_DISPLAY("", "CrowPanel E-Paper", this);
   ESP_LOGCONFIG(TAG, "  Model: 5.79in");
+  ESP_LOGCONFIG(TAG, "  Layout: %s", this->split_layout_ ? "per controller" : "single frame");
   LOG_PIN("  Reset Pin: ", this->reset_pin_);
   LOG_PIN("  DC Pin: ", this->dc_pin_);
   LOG_PIN("  Busy Pin: ", this->busy_pin_);
+  this->transport_->dump_config();
+  this->dump_update_config_();
   LOG_UPDATE_INTERVAL(this);
 }
 
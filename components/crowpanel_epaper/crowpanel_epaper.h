@@ -3,14 +3,42 @@
 #include "esphome/core/component.h"
 #include "esphome/components/display/display_buffer.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/version.h"
+#include "crowpanel_bus.h"
+#include "crowpanel_sequence.h"
+#include "crowpanel_transport.h"
+
+#ifdef USE_SENSOR
+#include "esphome/components/sensor/sensor.h"
+#endif
+#ifdef USE_TEXT_SENSOR
+#include "esphome/components/text_sensor/text_sensor.h"
+#endif
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
+#ifdef USE_CROWPANEL_EPAPER_FONT
+#include "esphome/components/font/font.h"
+#include "esphome/core/time.h"
+#endif
+
+#include <array>
+#include <cmath>
+#include <cstdarg>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Components can switch their own loop() off and wake it from an ISR since ESPHome 2025.7.
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 7, 0)
+#define CROWPANEL_EPAPER_LOOP_CONTROL
+#endif
 
 namespace esphome {
 namespace crowpanel_epaper {
 
-static const uint8_t COMMAND_END_MARKER = 0xFF;
-static const uint8_t DELAY_FLAG = 0x80;
-static const uint8_t ARG_COUNT_MASK = 0x7F;
-
 static const uint16_t NATIVE_WIDTH_4P2IN = 400; 
 static const uint16_t NATIVE_HEIGHT_4P2IN = 300;
 
@@ -28,35 +56,238 @@ enum class EpdState {
   INIT_WAIT_BUSY,
   INIT_DONE,
   UPDATE_START,
+  WAKE_RESET,
+  WAKE_WAIT_RESET,
+  WAKE_DONE,
   UPDATE_WAIT_BUSY,
   UPDATE_PREPARE,
   UPDATE_SENDING_DATA,
   UPDATE_REFRESH,
   UPDATE_WAIT_REFRESH,
+  UPDATE_SYNC_OLD_IMAGE,
   UPDATE_DONE,
+  RUN_SEQUENCE,
   DEEP_SLEEP,
 };
 
 enum class UpdateMode {
   FULL,
-  PARTIAL
+  PARTIAL,
+  // Full frame with a shortened waveform, see CrowPanelEPaperBase::set_temperature()
+  FAST,
+};
+
+// How soon a requested update may start, see CrowPanelEPaperBase::request_update().
+enum class UpdatePriority : uint8_t {
+  // Merged with other requests, waits for the minimum interval and the hourly budget
+  ROUTINE,
+  // Starts as soon as the panel is free, an alarm shouldn't wait for the budget
+  URGENT,
+};
+
+// Waveform registers of the SSD1683 (0x32), optionally followed by the EOPT (0x3F),
+// gate (0x03), source (0x04, 3 bytes) and VCOM (0x2C) settings that belong with them.
+static const size_t LUT_SIZE = 227;
+static const size_t LUT_SIZE_WITH_VOLTAGES = LUT_SIZE + 6;
+
+// Steps of the update pipeline that are timed, plus the longest loop() call of each update.
+enum class UpdatePhase : uint8_t {
+  RENDER,
+  WAKE,
+  WAIT_BUSY,
+  PREPARE,
+  SEND,
+  REFRESH,
+  LOOP,
+};
+static const uint8_t UPDATE_PHASE_COUNT = 7;
+
+// Rolling statistics over the last SIZE samples of one phase, in microseconds.
+struct PhaseStats {
+  static const uint8_t SIZE = 16;
+
+  void add(uint32_t sample);
+  uint8_t count() const { return this->count_; }
+  uint32_t min() const;
+  uint32_t max() const;
+  uint32_t avg() const;
+  uint32_t p95() const;
+
+ protected:
+  uint32_t samples_[SIZE]{};
+  uint8_t count_{0};
+  uint8_t next_{0};
+};
+
+// Position in a command sequence that is being run across several loop() calls.
+struct SequenceCursor {
+  const uint8_t *sequence{nullptr};
+  uint32_t index{0};
+  // Waits requested by the entry the cursor stopped at.
+  uint8_t delay_ms{0};
+  bool wait_busy{false};
+};
+
+// What the current upload writes. Partial refreshes compare the new-image RAM against the
+// old-image RAM, so after every refresh the old-image RAM is brought up to date as well.
+enum class UploadPass : uint8_t {
+  NEW_IMAGE,        // The frame, into the new-image RAM
+  CLEAN_OLD_IMAGE,  // The inverted frame, into the old-image RAM: every pixel gets driven
+  SYNC_OLD_IMAGE,   // The frame just shown, into the old-image RAM
+};
+
+// FNV-1a over a watched value, see CrowPanelEPaperBase::add_watch_probe().
+inline uint32_t watch_hash(const void *data, size_t len) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ bytes[i]) * 16777619UL;
+  return hash;
+}
+inline uint32_t watch_hash(const std::string &value) { return watch_hash(value.data(), value.size()); }
+template<typename T> uint32_t watch_hash(const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "Only plain values and strings can be watched");
+  return watch_hash(&value, sizeof(T));
+}
+
+// A rectangle of controller RAM in native buffer coordinates. Columns are byte columns (8 pixels).
+// Both ends are inclusive, matching the SSD1683's RAM address registers.
+struct RamWindow {
+  uint16_t x_start;
+  uint16_t x_end;
+  uint16_t y_start;
+  uint16_t y_end;
+
+  uint16_t width_bytes() const { return this->x_end - this->x_start + 1; }
+  uint16_t height() const { return this->y_end - this->y_start + 1; }
+  size_t size() const { return static_cast<size_t>(this->width_bytes()) * this->height(); }
 };
 
 class CrowPanelEPaperBase : public display::DisplayBuffer {
  public:
   void set_dc_pin(GPIOPin *dc_pin) { dc_pin_ = dc_pin; }
   void set_cs_pin(GPIOPin *cs_pin) { cs_pin_ = cs_pin; }
-  void set_clk_pin(GPIOPin *clk_pin) { clk_pin_ = clk_pin; }
-  void set_mosi_pin(GPIOPin *mosi_pin) { mosi_pin_ = mosi_pin; }
+  void set_transport(CrowPanelTransport *transport) { this->transport_ = transport; }
+  // Shares CLK/MOSI with other panels, the bus owns the transport and schedules uploads.
+  void set_bus(CrowPanelBus *bus) {
+    this->bus_ = bus;
+    this->transport_ = bus->get_transport();
+  }
   void set_reset_pin(GPIOPin *reset) { this->reset_pin_ = reset; }
+  // A pin with interrupts (a GPIO of the ESP32) wakes loop() when BUSY falls, any other pin, on an
+  // I/O expander say, is polled.
   void set_busy_pin(GPIOPin *busy) { this->busy_pin_ = busy; }
   
   void set_full_update_every(uint32_t full_update_every) { this->full_update_every_ = full_update_every; }
-  void set_rotation(display::DisplayRotation rotation) { this->rotation_ = rotation; }
+  // Ghosting control for automatic mode. With a churn threshold, a full update happens once the
+  // pixels flipped by partial updates in any region reach that fraction of the region, instead
+  // of every full_update_every updates; full_update_every is ignored then.
+  void set_full_update_churn(float churn) { this->churn_threshold_ = churn; }
+  void set_full_update_max_interval(uint32_t interval_ms) { this->full_update_max_interval_ = interval_ms; }
+  // Clean only the regions over the threshold, with a partial update that re-drives every pixel.
+  void set_regional_full_update(bool regional) { this->regional_full_update_ = regional; }
+#ifdef USE_TIME
+  // No full (flashing) updates between these minutes of the day; they are postponed.
+  void set_quiet_hours(time::RealTimeClock *clock, uint16_t start_minute, uint16_t end_minute) {
+    this->quiet_clock_ = clock;
+    this->quiet_start_ = start_minute;
+    this->quiet_end_ = end_minute;
+  }
+#endif
+  void set_rotation(display::DisplayRotation rotation) {
+    this->rotation_ = rotation;
+    this->on_rotation_changed_();
+    this->invalidate_background();
+  }
+  // Routine updates start at least this long after the previous refresh started.
+  void set_min_update_interval(uint32_t interval_ms) { this->min_update_interval_ = interval_ms; }
+  // Routine updates are held back once this many refreshes started within the last hour, 0 for
+  // no limit.
+  void set_max_refreshes_per_hour(uint16_t max_refreshes) {
+    this->max_refreshes_per_hour_ = max_refreshes;
+    this->refresh_history_.reserve(max_refreshes);
+  }
   void set_update_mode(UpdateMode mode) { 
     this->force_update_mode_ = mode; 
     this->has_forced_update_mode_ = true;
   }
+  // Ambient temperature in °C, used to pick the waveform for FAST updates. The panel's own sensor
+  // can't be read back without MISO, so it comes from the configuration instead.
+  void set_temperature(float temperature) { this->temperature_ = temperature; }
+  // Custom waveform for FAST updates, LUT_SIZE or LUT_SIZE_WITH_VOLTAGES bytes.
+  void set_fast_lut(const uint8_t *lut, size_t len) {
+    this->fast_lut_ = lut;
+    this->fast_lut_len_ = len;
+  }
+  // Render into a second framebuffer while the previous frame is still being sent or refreshed.
+  void set_double_buffer(bool double_buffer) { this->double_buffer_ = double_buffer; }
+  // Time update_send_data_ may spend streaming frame data per loop() call.
+  void set_send_budget(uint32_t send_budget_us) { this->send_budget_us_ = send_budget_us; }
+  // Put the controller into deep sleep after every refresh. It keeps its RAM there, so waking up
+  // only takes a hardware reset and the register setup, and partial updates carry on.
+  void set_sleep_between_updates(bool sleep) { this->sleep_between_updates_ = sleep; }
+  // Keep a copy of each page's last rendered frame. Switching back to a page shows that copy
+  // instead of running the page's writer again, until the page is invalidated. Nothing else
+  // notices that a cached page is out of date, only a change of a watched source drops it.
+  void set_page_cache(bool page_cache) { this->page_cache_ = page_cache; }
+  // Drops the cached frame of `page`, or of every page, so it is rendered again when shown next.
+  void invalidate_page_cache(const display::DisplayPage *page = nullptr);
+
+  // Draws the background layer again before the next frame, for when what it shows changed.
+  // Cached pages include the old background, so they are dropped too.
+  void invalidate_background() {
+    this->background_valid_ = false;
+    this->invalidate_page_cache();
+  }
+
+  // Watched sources: once any are added, update() only redraws when one of them changed since the
+  // last frame was drawn (or the page changed), and a change requests an update right away.
+  // A probe returns a hash of what the frame shows from that source.
+  void add_watch_probe(std::function<uint32_t()> &&probe, bool polled);
+  template<typename G> void add_watched_global(G *global) {
+    this->add_watch_probe([global]() { return watch_hash(global->value()); }, true);
+  }
+#ifdef USE_SENSOR
+  void add_watched_sensor(sensor::Sensor *sensor);
+#endif
+#ifdef USE_TEXT_SENSOR
+  void add_watched_text_sensor(text_sensor::TextSensor *sensor);
+#endif
+#ifdef USE_TIME
+  // Changes once every `granularity_s` seconds of local time, e.g. 60 for a clock without seconds.
+  void set_watched_time(time::RealTimeClock *clock, uint32_t granularity_s);
+#endif
+  // How often globals and the time are probed; sensors report changes themselves.
+  void set_watch_interval(uint32_t interval_ms) { this->watch_interval_ = interval_ms; }
+
+#ifdef USE_SENSOR
+  void set_skipped_updates_sensor(sensor::Sensor *sensor) { this->skipped_updates_sensor_ = sensor; }
+  void set_refreshes_sensor(sensor::Sensor *sensor) { this->refreshes_sensor_ = sensor; }
+  void set_upload_throughput_sensor(sensor::Sensor *sensor) { this->upload_throughput_sensor_ = sensor; }
+  void set_temperature_sensor(sensor::Sensor *sensor) {
+    sensor->add_on_state_callback([this](float state) { this->set_temperature(state); });
+  }
+  void set_bus_bytes_sensor(sensor::Sensor *sensor) { this->bus_bytes_sensor_ = sensor; }
+  void set_phase_sensor(UpdatePhase phase, sensor::Sensor *sensor) {
+    this->phase_sensors_[static_cast<uint8_t>(phase)] = sensor;
+  }
+#endif
+
+  // Updates whose rendered frame matched the panel and were dropped, and refreshes actually performed.
+  uint32_t get_skipped_update_count() const { return this->skipped_update_count_; }
+  uint32_t get_refresh_count() const { return this->refresh_count_; }
+  // How long the panel kept BUSY high for the last refresh, from the falling edge.
+  uint32_t get_last_refresh_duration_us() const { return this->refresh_duration_us_; }
+  const PhaseStats &get_phase_stats(UpdatePhase phase) const {
+    return this->phase_stats_[static_cast<uint8_t>(phase)];
+  }
+
+  // Asks for a new frame. Requests made before it starts are merged into one: the highest priority
+  // wins, and so does the strongest mode asked for (FULL over FAST over PARTIAL). Without a mode
+  // the configured or automatic choice applies. update() is a routine request. An unchanged frame
+  // is skipped, unless FULL or FAST was asked for.
+  void request_update(UpdatePriority priority = UpdatePriority::ROUTINE);
+  void request_update(UpdatePriority priority, UpdateMode mode);
 
   float get_setup_priority() const override { return setup_priority::HARDWARE; } 
   void setup() override;
@@ -69,68 +300,554 @@ class CrowPanelEPaperBase : public display::DisplayBuffer {
   void data(uint8_t value);
   
  protected:
-  void setup_pins_();
-  uint32_t get_buffer_length_();
+  // Returns false if the transport could not be set up.
+  bool setup_pins_();
+  void run_state_machine_(uint32_t now);
+  void record_phase_(UpdatePhase phase, uint32_t duration_us);
+  // Settings and statistics shared by the models' dump_config().
+  void dump_update_config_();
+  virtual uint32_t get_buffer_length_();
+  uint16_t get_row_stride_() { return this->get_width_controller() / 8u; }
   
   virtual void initialize() = 0;
   virtual void display() = 0;
   virtual void deep_sleep() = 0;
+  // Register setup after waking from deep sleep: the start sequence without the soft reset.
+  virtual const uint8_t *wake_sequence_() = 0;
   
   void start_command_();
-  void end_command_();
   void start_data_();
   void end_data_();
-  void write_byte_soft_spi(uint8_t data);
+  // Sends `command` and leaves CS low with D/C high, ready for its data.
+  void start_write_(uint8_t command);
+  // A command and all its arguments in one CS-low burst.
+  void transfer_array_(uint8_t command, const uint8_t *args, size_t len);
+  template<typename... Args> void transfer_(uint8_t command, Args... args) {
+    const std::array<uint8_t, sizeof...(Args)> data{static_cast<uint8_t>(args)...};
+    this->transfer_array_(command, data.data(), data.size());
+  }
+  void write_byte_(uint8_t data) {
+    this->bus_bytes_[this->bus_command_]++;
+    this->transport_->write_byte(data);
+  }
+  void write_array_(const uint8_t *data, size_t len) {
+    this->bus_bytes_[this->bus_command_] += len;
+    this->transport_->write_array(data, len);
+  }
+  // Runs a whole sequence, blocking through its delays and busy waits. Only for shutdown.
   void send_command_sequence_(const uint8_t* sequence);
+  // Runs a sequence from loop() and continues with `next_state` once it is done.
+  void start_sequence_(const uint8_t *sequence, EpdState next_state);
+  // Sends entries up to the next one that asks for a wait. Returns true at the end of the sequence.
+  bool send_sequence_until_wait_(SequenceCursor *cursor);
+  void run_sequence_(uint32_t now);
   
   bool is_idle_();
   bool check_busy_pin_();
+  // BUSY is watched with a falling-edge interrupt. arm_busy_wait_() starts a wait, busy_wait_done_()
+  // then only looks at the flag set by the ISR (or the idle timeout). Without an interrupt,
+  // busy_wait_done_() reads the pin.
+  static void busy_isr_(CrowPanelEPaperBase *arg);
+  void arm_busy_wait_();
+  bool busy_wait_done_(uint32_t now);
   virtual void do_update_();
   
   virtual int get_width_controller() { return this->get_width_internal(); }
   virtual uint32_t idle_timeout_() { return 1000u; }
   
-  bool calculate_rotated_coords_(int x, int y, int width, int height, int *out_x, int *out_y);
+  virtual void on_rotation_changed_() {}
+  // Cascaded panels need waveform settings sent to both controllers.
+  virtual bool has_secondary_controller_() { return false; }
+
+  // Picks FAST, or FULL when it is too cold for the short waveform.
+  UpdateMode resolve_fast_mode_();
+  UpdateMode choose_update_mode_(uint32_t now);
+  bool in_quiet_hours_();
+  // Adds the pixels about to be committed to the per-region churn.
+  void track_churn_();
+  // Bounding box of the regions whose churn crossed the threshold.
+  bool find_hot_regions_(RamWindow *window);
+  void reset_churn_(const RamWindow &window);
+  // Refresh sequence for FAST updates, for the temperature or the custom LUT.
+  const uint8_t *fast_refresh_sequence_();
+  void write_fast_lut_();
 
   virtual void update_send_data_(uint32_t now);
 
+  // Clears the draw buffer and runs the page or lambda into it. render_frame_() also times it.
+  void draw_frame_();
+  void render_frame_();
+  // The drawing part of draw_frame_(): background, then the page or lambda. Leaves the page cache
+  // and the record of what was drawn alone.
+  void draw_content_();
+  // Hands the freshly rendered frame over for upload. With double buffering the draw and
+  // transfer buffers trade places; otherwise they are the same buffer.
+  void swap_buffers_();
+  bool can_prerender_();
+  // Starts a frame: a blank buffer, or a copy of the background layer, drawn first if needed.
+  void draw_background_();
+  // The cache slot for `page`, allocated on first use. nullptr if there is no memory for it.
+  struct PageCacheEntry;
+  PageCacheEntry *page_cache_entry_(const display::DisplayPage *page);
+  void queue_request_(UpdatePriority priority, bool has_mode, UpdateMode mode);
+  // Whether the pending request may start now. Logs why not, once per request.
+  bool update_allowed_(uint32_t now);
+  void record_refresh_start_(uint32_t now);
+
+  // Re-runs the probes. Returns true if a watched source changed since the last frame was drawn.
+  bool probe_watched_();
+  void on_watched_change_();
+
+  // Picks the RAM window for the next upload: the whole frame for full updates, otherwise the
+  // bounding box of bytes that differ from the last uploaded frame.
+  void prepare_window_();
+  // Sets the RAM address counters to the start of the window being sent and starts writing
+  // `command` (new or old image RAM) there.
+  virtual void start_ram_write_(uint8_t command) = 0;
+  // start_ram_write_(), then on a shared bus CS goes up until the first slice.
+  void begin_ram_write_(uint8_t command);
+  void start_upload_pass_(UploadPass pass);
+  // Called by update_send_data_() once the current pass is complete.
+  void finish_upload_pass_(uint32_t now);
+  uint8_t ram_command_();
+  bool find_dirty_window_(RamWindow *window);
+  // Shrinks the rows of `window` to those that differ from the last uploaded frame within its
+  // columns. Returns false if none do.
+  bool narrow_dirty_rows_(RamWindow *window);
+  // Streams the next part of `window` from the buffer, tracking progress in data_send_index_.
+  // Returns true once the whole window has been sent.
+  bool send_window_chunk_(const RamWindow &window, size_t max_bytes);
+  // Sends as much of `window` as fits in the send budget at the measured rate, and updates the
+  // rate from how long that took. Returns true once the whole window has been sent.
+  bool send_window_budgeted_(const RamWindow &window);
+  // Ends the RAM write after the last chunk and moves on to the refresh.
+  void finish_upload_(uint32_t now);
+  // Records the uploaded window as the controller's current RAM contents.
+  void commit_window_();
+  bool is_frame_unchanged_();
+
   GPIOPin *dc_pin_{nullptr};
   GPIOPin *cs_pin_{nullptr};
-  GPIOPin *clk_pin_{nullptr};
-  GPIOPin *mosi_pin_{nullptr};
+  CrowPanelTransport *transport_{nullptr};
+  CrowPanelBus *bus_{nullptr};
   GPIOPin *reset_pin_{nullptr};
   GPIOPin *busy_pin_{nullptr};
+  bool busy_interrupt_{false};
+  volatile bool busy_released_{false};
+  volatile uint32_t busy_released_us_{0};
+  uint32_t refresh_start_us_{0};
+  uint32_t refresh_duration_us_{0};
 
   uint32_t full_update_every_{10};
   uint32_t update_count_{0};
+  uint32_t skipped_update_count_{0};
+  uint32_t refresh_count_{0};
   display::DisplayRotation rotation_{display::DISPLAY_ROTATION_0_DEGREES};
   
   EpdState state_{EpdState::IDLE};
   uint32_t state_start_time_{0};
   uint32_t data_send_index_{0};
+  SequenceCursor sequence_{};
+  EpdState sequence_next_state_{EpdState::IDLE};
+  RamWindow update_window_{};
+  // Frame being uploaded. Equals buffer_ unless double buffering is enabled, in which case
+  // buffer_ is free for drawing the next frame in the meantime.
+  uint8_t *transfer_buffer_{nullptr};
+  bool double_buffer_{false};
+  bool sleep_between_updates_{false};
+  // The controller is in deep sleep and needs a reset before the next update.
+  bool asleep_{false};
+  uint32_t wake_start_us_{0};
+  // The draw buffer already holds the frame for the pending update.
+  bool frame_ready_{false};
+  struct PageCacheEntry {
+    const display::DisplayPage *page;
+    uint8_t *frame;
+    bool valid;
+  };
+  // Static content under every frame, see CrowPanelEPaper::set_background_writer().
+  display::display_writer_t background_writer_{};
+  uint8_t *background_{nullptr};
+  bool background_valid_{false};
+  bool page_cache_{false};
+  std::vector<PageCacheEntry> page_cache_entries_;
+  // Page drawn into the buffer last. Updates on the same page render it, its data may have changed.
+  const display::DisplayPage *last_drawn_page_{nullptr};
+  struct WatchedSource {
+    std::function<uint32_t()> probe;
+    uint32_t hash;
+  };
+  std::vector<WatchedSource> watched_;
+  bool watch_polled_{false};
+  uint32_t watch_interval_{1000};
+  // Bumped whenever a probe sees a new value; drawn_generation_ is its value at the last draw.
+  uint32_t watch_generation_{0};
+  uint32_t drawn_generation_{UINT32_MAX};
+  // Copy of the last frame uploaded to the controller, used to find what changed.
+  uint8_t *previous_buffer_{nullptr};
+  bool previous_valid_{false};
+  uint32_t send_budget_us_{4000};
+  // Measured transport rate in bytes per microsecond. Zero until the first chunk went out.
+  float send_rate_{0.0f};
+  uint32_t upload_start_us_{0};
+  uint32_t upload_bytes_{0};
+  // Last upload's bytes over its wall time, loop() gaps included.
+  float upload_throughput_{0.0f};
+  HighFrequencyLoopRequester high_freq_;
+  PhaseStats phase_stats_[UPDATE_PHASE_COUNT];
+  uint32_t busy_wait_start_us_{0};
+  // Longest loop() call since the current update started.
+  uint32_t max_loop_us_{0};
+  // Bytes clocked out since the current update started, data [0] and command [1] bytes.
+  uint32_t bus_bytes_[2]{0, 0};
+  bool bus_command_{false};
+  // Mode of the update in progress. is_full_update_ is set for every mode that sends the whole frame.
+  UpdateMode update_mode_{UpdateMode::FULL};
   bool is_full_update_{false};
+
+  // Churn is tracked on a CHURN_GRID x CHURN_GRID grid over the native buffer.
+  static const uint8_t CHURN_GRID = 4;
+  uint32_t churn_[CHURN_GRID * CHURN_GRID]{};
+  float churn_threshold_{0.0f};
+  uint32_t full_update_max_interval_{0};
+  uint32_t last_full_update_{0};
+  bool regional_full_update_{false};
+  // Set for a regional cleaning update: clean_window_ is re-driven through the old-image RAM.
+  bool invert_old_image_{false};
+  RamWindow clean_window_{};
+  UploadPass upload_pass_{UploadPass::NEW_IMAGE};
+#ifdef USE_TIME
+  time::RealTimeClock *quiet_clock_{nullptr};
+  uint16_t quiet_start_{0};
+  uint16_t quiet_end_{0};
+#endif
+  // A full update came due during quiet hours, it runs with the first update after them.
+  bool full_update_postponed_{false};
+  float temperature_{NAN};
+  const uint8_t *fast_lut_{nullptr};
+  size_t fast_lut_len_{0};
   bool needs_update_{false};
+  // The pending request, merged from everything asked for since the last update started.
+  UpdatePriority pending_priority_{UpdatePriority::ROUTINE};
+  bool pending_has_mode_{false};
+  UpdateMode pending_mode_{UpdateMode::FULL};
+  bool pending_deferred_{false};
+  // The mode asked for by the update in progress, if any.
+  bool requested_has_mode_{false};
+  UpdateMode requested_mode_{UpdateMode::FULL};
+  uint32_t min_update_interval_{0};
+  uint32_t last_refresh_start_{0};
+  uint16_t max_refreshes_per_hour_{0};
+  // Start times of the refreshes within the budget window, oldest first.
+  std::vector<uint32_t> refresh_history_;
   
   bool has_forced_update_mode_{false};
   UpdateMode force_update_mode_{UpdateMode::FULL};
+
+#ifdef USE_SENSOR
+  sensor::Sensor *skipped_updates_sensor_{nullptr};
+  sensor::Sensor *refreshes_sensor_{nullptr};
+  sensor::Sensor *upload_throughput_sensor_{nullptr};
+  sensor::Sensor *bus_bytes_sensor_{nullptr};
+  sensor::Sensor *phase_sensors_[UPDATE_PHASE_COUNT]{};
+#endif
 };
 
+class CrowPanelEPaper;
+using crowpanel_writer_t = std::function<void(CrowPanelEPaper &)>;
+
 class CrowPanelEPaper : public CrowPanelEPaperBase {
  public:
   void fill(Color color) override;
   display::DisplayType get_display_type() override { return display::DisplayType::DISPLAY_TYPE_BINARY; }
 
+  // The display lambda gets a CrowPanelEPaper reference, so the byte-granular primitives below
+  // take precedence over the per-pixel ones from display::Display.
+  void set_panel_writer(crowpanel_writer_t &&writer) {
+    this->set_writer([this, writer](display::Display &) { writer(*this); });
+  }
+  // Same for the pages: display.py builds each display::DisplayPage from this writer.
+  display::display_writer_t page_writer(crowpanel_writer_t &&writer) {
+    return [this, writer](display::Display &) { writer(*this); };
+  }
+  // Fixed content, drawn once into a retained layer. Each frame starts as a copy of that layer
+  // instead of a blank buffer, and the page or lambda only draws what changes on top of it.
+  // Replacing the writer draws the layer again.
+  void set_background_writer(crowpanel_writer_t &&writer) {
+    this->background_writer_ = [this, writer](display::Display &) { writer(*this); };
+    this->invalidate_background();
+  }
+
+  void line(int x1, int y1, int x2, int y2, Color color = display::COLOR_ON);
+  void horizontal_line(int x, int y, int width, Color color = display::COLOR_ON);
+  void vertical_line(int x, int y, int height, Color color = display::COLOR_ON);
+  void rectangle(int x1, int y1, int width, int height, Color color = display::COLOR_ON);
+  void filled_rectangle(int x1, int y1, int width, int height, Color color = display::COLOR_ON);
+
+  // Times the drawing primitives at every rotation, text (with a font) and one render of the
+  // configured page or lambda, and logs a "BENCH" line per case. Only runs while the panel is
+  // idle. Leaves the panel as it was: the frame, rotation and caches are restored or untouched.
+#ifdef USE_CROWPANEL_EPAPER_FONT
+  void run_benchmark(font::Font *font = nullptr);
+#else
+  void run_benchmark();
+#endif
+
+#ifdef USE_CROWPANEL_EPAPER_FONT
+  // Text with a font::Font is blitted glyph row by glyph row straight into the native buffer.
+  // Anti-aliased fonts and other font types go through display::Display as before.
+  using display::Display::print;
+  using display::Display::printf;
+  using display::Display::strftime;
+
+  void print(int x, int y, font::Font *font, Color color, display::TextAlign align, const char *text,
+             Color background = display::COLOR_OFF);
+  void print(int x, int y, font::Font *font, Color color, const char *text, Color background = display::COLOR_OFF) {
+    this->print(x, y, font, color, display::TextAlign::TOP_LEFT, text, background);
+  }
+  void print(int x, int y, font::Font *font, display::TextAlign align, const char *text) {
+    this->print(x, y, font, display::COLOR_ON, align, text);
+  }
+  void print(int x, int y, font::Font *font, const char *text) {
+    this->print(x, y, font, display::COLOR_ON, display::TextAlign::TOP_LEFT, text);
+  }
+
+  void printf(int x, int y, font::Font *font, Color color, Color background, display::TextAlign align,
+              const char *format, ...) __attribute__((format(printf, 8, 9)));
+  void printf(int x, int y, font::Font *font, Color color, display::TextAlign align, const char *format, ...)
+      __attribute__((format(printf, 7, 8)));
+  void printf(int x, int y, font::Font *font, Color color, const char *format, ...)
+      __attribute__((format(printf, 6, 7)));
+  void printf(int x, int y, font::Font *font, display::TextAlign align, const char *format, ...)
+      __attribute__((format(printf, 6, 7)));
+  void printf(int x, int y, font::Font *font, const char *format, ...) __attribute__((format(printf, 5, 6)));
+
+  void strftime(int x, int y, font::Font *font, Color color, display::TextAlign align, const char *format,
+                ESPTime time) __attribute__((format(strftime, 7, 0)));
+  void strftime(int x, int y, font::Font *font, Color color, const char *format, ESPTime time)
+      __attribute__((format(strftime, 6, 0))) {
+    this->strftime(x, y, font, color, display::TextAlign::TOP_LEFT, format, time);
+  }
+  void strftime(int x, int y, font::Font *font, display::TextAlign align, const char *format, ESPTime time)
+      __attribute__((format(strftime, 6, 0))) {
+    this->strftime(x, y, font, display::COLOR_ON, align, format, time);
+  }
+  void strftime(int x, int y, font::Font *font, const char *format, ESPTime time)
+      __attribute__((format(strftime, 5, 0))) {
+    this->strftime(x, y, font, display::COLOR_ON, display::TextAlign::TOP_LEFT, format, time);
+  }
+#endif
+
  protected:
+  // Writes one logical (rotated) pixel into a native buffer. Specialized per geometry and rotation.
+  using PixelWriter = void (*)(uint8_t *buffer, int x, int y, bool on);
+
   void draw_absolute_pixel_internal(int x, int y, Color color) override;
+
+  // Maps a logical pixel to native buffer coordinates for the current rotation.
+  virtual void map_to_native_(int x, int y, int *native_x, int *native_y) = 0;
+  // Sets or clears an inclusive rectangle of the native buffer, whole bytes at a time.
+  void fill_native_rect_(int x1, int y1, int x2, int y2, bool on);
+
+  // Native pixel columns [x_start, x_end], stored row-major from `offset` with the row stride.
+  // The frame is a single plane, unless a model stores it per controller.
+  struct NativePlane {
+    uint16_t x_start;
+    uint16_t x_end;
+    uint32_t offset;
+  };
+  NativePlane planes_[2]{};
+  uint8_t plane_count_{1};
+
+#ifdef USE_CROWPANEL_EPAPER_FONT
+  void vprintf_panel_(int x, int y, font::Font *font, Color color, Color background, display::TextAlign align,
+                      const char *format, va_list arg);
+#endif
+  // Draws the set bits of a packed 1bpp bitmap (rows not padded, MSB first) at a logical position.
+  // Clear bits are transparent.
+  void blit_bitmap_(int x, int y, int width, int height, const uint8_t *data, bool on);
   
   virtual int get_native_width_() = 0;
   virtual int get_native_height_() = 0;
   
   int get_width_internal() override;
   int get_height_internal() override;
+
+  PixelWriter pixel_writer_{nullptr};
+};
+
+// Compile-time geometry of a panel. The buffer is stored in the controller's native orientation,
+// one bit per pixel, MSB first, with the X axis mirrored.
+//
+// Cascaded panels may also store the frame as two planes of SplitWidth columns, the left and right
+// controller's, one after the other. The columns both controllers drive are kept in both planes.
+template<uint16_t Width, uint16_t Height, uint16_t SplitWidth = 0> struct PanelGeometry {
+  static_assert(Width % 8 == 0, "Native width must be a whole number of bytes");
+  static_assert(SplitWidth % 8 == 0 && (SplitWidth == 0 || (SplitWidth < Width && 2 * SplitWidth >= Width)),
+                "Split planes must be whole bytes and cover the panel");
+  static constexpr uint16_t NATIVE_WIDTH = Width;
+  static constexpr uint16_t NATIVE_HEIGHT = Height;
+  static constexpr uint16_t ROW_STRIDE = Width / 8u;
+  static constexpr uint32_t BUFFER_LENGTH = static_cast<uint32_t>(ROW_STRIDE) * Height;
+
+  static constexpr uint16_t SPLIT_WIDTH = SplitWidth;
+  static constexpr uint16_t SPLIT_STRIDE = SplitWidth / 8u;
+  // First native column of the second plane
+  static constexpr uint16_t SPLIT_SECOND_X = Width - SplitWidth;
+  static constexpr uint32_t SPLIT_BUFFER_LENGTH = 2u * SPLIT_STRIDE * Height;
 };
 
-class CrowPanelEPaper4P2In : public CrowPanelEPaper {
+using Geometry4P2In = PanelGeometry<NATIVE_WIDTH_4P2IN, NATIVE_HEIGHT_4P2IN>;
+// Each controller drives 400 columns, they share the middle 8.
+using Geometry5P79In = PanelGeometry<NATIVE_WIDTH_5P79IN, NATIVE_HEIGHT_5P79IN, 400>;
+
+// Binds a CrowPanelEPaper to a fixed geometry, so the per-pixel path works on constants
+// and the rotation is resolved once in set_rotation() instead of per pixel.
+template<typename Geometry> class CrowPanelEPaperPanel : public CrowPanelEPaper {
+ public:
+  CrowPanelEPaperPanel() {
+    this->planes_[0] = {0, Geometry::NATIVE_WIDTH - 1, 0};
+    this->on_rotation_changed_();
+  }
+
+ protected:
+  int get_native_width_() final { return Geometry::NATIVE_WIDTH; }
+  int get_native_height_() final { return Geometry::NATIVE_HEIGHT; }
+  // With the split layout, a buffer row is one controller's row.
+  int get_width_controller() final { return this->split_layout_ ? Geometry::SPLIT_WIDTH : Geometry::NATIVE_WIDTH; }
+  uint32_t get_buffer_length_() final {
+    return this->split_layout_ ? Geometry::SPLIT_BUFFER_LENGTH : Geometry::BUFFER_LENGTH;
+  }
+
+  // Switches to the per-controller layout of geometries with a SPLIT_WIDTH. Only before setup().
+  void set_split_layout_(bool split) {
+    static_assert(Geometry::SPLIT_WIDTH != 0, "This panel has no split layout");
+    this->split_layout_ = split;
+    this->plane_count_ = split ? 2 : 1;
+    if (split) {
+      this->planes_[0] = {0, Geometry::SPLIT_WIDTH - 1, 0};
+      this->planes_[1] = {Geometry::SPLIT_SECOND_X, Geometry::NATIVE_WIDTH - 1,
+                          static_cast<uint32_t>(Geometry::SPLIT_STRIDE) * Geometry::NATIVE_HEIGHT};
+    } else {
+      this->planes_[0] = {0, Geometry::NATIVE_WIDTH - 1, 0};
+    }
+    this->on_rotation_changed_();
+  }
+
+  void on_rotation_changed_() override {
+    switch (this->rotation_) {
+      case display::DISPLAY_ROTATION_90_DEGREES:
+        this->pixel_writer_ = this->pixel_writer_for_<display::DISPLAY_ROTATION_90_DEGREES>();
+        break;
+      case display::DISPLAY_ROTATION_180_DEGREES:
+        this->pixel_writer_ = this->pixel_writer_for_<display::DISPLAY_ROTATION_180_DEGREES>();
+        break;
+      case display::DISPLAY_ROTATION_270_DEGREES:
+        this->pixel_writer_ = this->pixel_writer_for_<display::DISPLAY_ROTATION_270_DEGREES>();
+        break;
+      case display::DISPLAY_ROTATION_0_DEGREES:
+      default:
+        this->pixel_writer_ = this->pixel_writer_for_<display::DISPLAY_ROTATION_0_DEGREES>();
+        break;
+    }
+  }
+
+  template<display::DisplayRotation Rotation> PixelWriter pixel_writer_for_() {
+    if constexpr (Geometry::SPLIT_WIDTH != 0) {
+      if (this->split_layout_)
+        return &write_pixel_split_<Rotation>;
+    }
+    return &write_pixel_<Rotation>;
+  }
+
+  void map_to_native_(int x, int y, int *native_x, int *native_y) override {
+    switch (this->rotation_) {
+      case display::DISPLAY_ROTATION_90_DEGREES:
+        to_native_<display::DISPLAY_ROTATION_90_DEGREES>(x, y, native_x, native_y);
+        break;
+      case display::DISPLAY_ROTATION_180_DEGREES:
+        to_native_<display::DISPLAY_ROTATION_180_DEGREES>(x, y, native_x, native_y);
+        break;
+      case display::DISPLAY_ROTATION_270_DEGREES:
+        to_native_<display::DISPLAY_ROTATION_270_DEGREES>(x, y, native_x, native_y);
+        break;
+      case display::DISPLAY_ROTATION_0_DEGREES:
+      default:
+        to_native_<display::DISPLAY_ROTATION_0_DEGREES>(x, y, native_x, native_y);
+        break;
+    }
+  }
+
+  // Maps a logical pixel to native buffer coordinates, mirror included.
+  template<display::DisplayRotation Rotation> static inline void to_native_(int x, int y, int *native_x, int *native_y) {
+    constexpr int W = Geometry::NATIVE_WIDTH;
+    constexpr int H = Geometry::NATIVE_HEIGHT;
+    if constexpr (Rotation == display::DISPLAY_ROTATION_90_DEGREES) {
+      *native_x = W - 1 - y;
+      *native_y = H - 1 - x;
+    } else if constexpr (Rotation == display::DISPLAY_ROTATION_180_DEGREES) {
+      *native_x = x;
+      *native_y = H - 1 - y;
+    } else if constexpr (Rotation == display::DISPLAY_ROTATION_270_DEGREES) {
+      *native_x = y;
+      *native_y = x;
+    } else {
+      *native_x = W - 1 - x;
+      *native_y = y;
+    }
+  }
+
+  template<display::DisplayRotation Rotation> static inline bool in_bounds_(int x, int y) {
+    constexpr bool SWAPPED =
+        Rotation == display::DISPLAY_ROTATION_90_DEGREES || Rotation == display::DISPLAY_ROTATION_270_DEGREES;
+    constexpr unsigned LOGICAL_WIDTH = SWAPPED ? Geometry::NATIVE_HEIGHT : Geometry::NATIVE_WIDTH;
+    constexpr unsigned LOGICAL_HEIGHT = SWAPPED ? Geometry::NATIVE_WIDTH : Geometry::NATIVE_HEIGHT;
+    // One unsigned compare per axis also rejects negative coordinates.
+    return static_cast<unsigned>(x) < LOGICAL_WIDTH && static_cast<unsigned>(y) < LOGICAL_HEIGHT;
+  }
+
+  static inline void write_bit_(uint8_t &byte, uint8_t mask, bool on) {
+    // Since this is an EPD, on is black and off is white.
+    if (on) {
+      byte &= ~mask;
+    } else {
+      byte |= mask;
+    }
+  }
+
+  template<display::DisplayRotation Rotation> static void write_pixel_(uint8_t *buffer, int x, int y, bool on) {
+    if (!in_bounds_<Rotation>(x, y))
+      return;
+
+    int native_x, native_y;
+    to_native_<Rotation>(x, y, &native_x, &native_y);
+    const uint32_t pos = static_cast<uint32_t>(native_y) * Geometry::ROW_STRIDE + (static_cast<uint32_t>(native_x) >> 3);
+    write_bit_(buffer[pos], 0x80 >> (native_x & 7), on);  // MSB is leftmost pixel
+  }
+
+  template<display::DisplayRotation Rotation> static void write_pixel_split_(uint8_t *buffer, int x, int y, bool on) {
+    if (!in_bounds_<Rotation>(x, y))
+      return;
+
+    int native_x, native_y;
+    to_native_<Rotation>(x, y, &native_x, &native_y);
+    // Both planes start on a byte boundary, so the bit is the same in either.
+    const uint8_t mask = 0x80 >> (native_x & 7);
+    if (native_x < Geometry::SPLIT_WIDTH) {
+      const uint32_t pos = static_cast<uint32_t>(native_y) * Geometry::SPLIT_STRIDE + (native_x >> 3);
+      write_bit_(buffer[pos], mask, on);
+    }
+    if (native_x >= Geometry::SPLIT_SECOND_X) {
+      const uint32_t row = Geometry::NATIVE_HEIGHT + native_y;
+      const uint32_t pos = row * Geometry::SPLIT_STRIDE + ((native_x - Geometry::SPLIT_SECOND_X) >> 3);
+      write_bit_(buffer[pos], mask, on);
+    }
+  }
+
+  bool split_layout_{false};
+};
+
+class CrowPanelEPaper4P2In : public CrowPanelEPaperPanel<Geometry4P2In> {
  public:
   void initialize() override;
   void display() override;
@@ -139,11 +856,10 @@ class CrowPanelEPaper4P2In : public CrowPanelEPaper {
   
  protected:
   uint32_t idle_timeout_() override { return 60000u; }
-  int get_width_controller() override { return NATIVE_WIDTH_4P2IN; }
-  int get_native_width_() override { return NATIVE_WIDTH_4P2IN; }
-  int get_native_height_() override { return NATIVE_HEIGHT_4P2IN; }
   
+  const uint8_t *wake_sequence_() override;
   void prepare_for_update_(UpdateMode mode);
+  void start_ram_write_(uint8_t command) override;
 };
 
 enum class EpdCascadeState {
@@ -151,8 +867,12 @@ enum class EpdCascadeState {
   SECONDARY,
 };
 
-class CrowPanelEPaper5P79In : public CrowPanelEPaper {
+class CrowPanelEPaper5P79In : public CrowPanelEPaperPanel<Geometry5P79In> {
  public:
+  // Store each controller's half of the frame contiguously, in the order it is sent. The upload
+  // is then one linear run per controller. Takes 272 more bytes per buffer.
+  void set_split_layout(bool split) { this->set_split_layout_(split); }
+
   void initialize() override;
   void display() override;
   void dump_config() override;
@@ -160,16 +880,29 @@ class CrowPanelEPaper5P79In : public CrowPanelEPaper {
   
  protected:
   EpdCascadeState cascade_state_{EpdCascadeState::PRIMARY};
-  // We use 2-dimensional addressing to stay sane.
-  // data_send_index_ is the y index.
-  uint32_t data_send_x_offset_{0};
+  // Per controller, indexed by EpdCascadeState: the rows it gets this update, and whether it gets
+  // any at all.
+  RamWindow controller_windows_[2]{};
+  bool controller_active_[2]{};
+
+  // All of the buffer that belongs to the given controller.
+  RamWindow controller_area_(EpdCascadeState controller);
+  // Splits update_window_ between the controllers, narrowing each to its own changed rows.
+  void prepare_controller_windows_();
+  // The part of update_window_ that goes to the given controller, in buffer coordinates. Returns
+  // false if the controller gets nothing this time.
+  bool controller_window_(EpdCascadeState controller, RamWindow *window);
+  // Buffer row of the controller's first RAM row.
+  uint16_t controller_first_row_(EpdCascadeState controller);
+  EpdCascadeState first_controller_();
+  void set_controller_window_(EpdCascadeState controller);
 
   uint32_t idle_timeout_() override { return 60000u; }
-  int get_width_controller() override { return NATIVE_WIDTH_5P79IN; }
-  int get_native_width_() override { return NATIVE_WIDTH_5P79IN; }
-  int get_native_height_() override { return NATIVE_HEIGHT_5P79IN; }
+  bool has_secondary_controller_() override { return true; }
+  const uint8_t *wake_sequence_() override;
 
   void prepare_for_update_(UpdateMode mode);
+  void start_ram_write_(uint8_t command) override;
   void update_send_data_(uint32_t now) override;
 };
 
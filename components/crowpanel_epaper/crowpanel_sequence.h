@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace crowpanel_epaper {
+
+// Command sequences are flat byte arrays run by CrowPanelEPaperBase:
+//   command, num_args | flags, [delay_ms], args...
+// Flags in num_args ask for a wait after the command and its args: DELAY_FLAG waits for the
+// delay_ms byte that follows, WAIT_BUSY_FLAG waits for BUSY to go low. With both the delay comes
+// first. Two COMMAND_END_MARKER bytes end the sequence.
+static const uint8_t COMMAND_END_MARKER = 0xFF;
+static const uint8_t DELAY_FLAG = 0x80;
+static const uint8_t WAIT_BUSY_FLAG = 0x40;
+static const uint8_t ARG_COUNT_MASK = 0x3F;
+
+// A sequence, or a part of one, built at compile time from the entries below:
+//
+//   static constexpr auto wake = make_sequence(cmd(CMD_SET_MUX, 0x2b, 0x01, 0x00), cmd_delay(CMD_DISPLAY_UPDATE, 10));
+//
+// Argument counts are derived from the arguments and every value is checked to fit a byte, so
+// the tables can't get out of step with the parser.
+template<size_t N> struct SequenceBytes {
+  uint8_t bytes[N];
+
+  constexpr size_t size() const { return N; }
+  constexpr const uint8_t *data() const { return this->bytes; }
+};
+
+namespace sequence_detail {
+
+// Deliberately not constexpr: reaching it while building a sequence is a compile error.
+void value_out_of_range();
+
+constexpr uint8_t to_byte(int value) {
+  return (value < 0 || value > 0xFF) ? (value_out_of_range(), 0) : static_cast<uint8_t>(value);
+}
+
+template<size_t A, size_t B> constexpr SequenceBytes<A + B> join(const SequenceBytes<A> &a, const SequenceBytes<B> &b) {
+  SequenceBytes<A + B> out{};
+  for (size_t i = 0; i < A; i++)
+    out.bytes[i] = a.bytes[i];
+  for (size_t i = 0; i < B; i++)
+    out.bytes[A + i] = b.bytes[i];
+  return out;
+}
+
+template<size_t A> constexpr SequenceBytes<A> join_all(const SequenceBytes<A> &a) { return a; }
+
+template<size_t A, size_t B, typename... Rest>
+constexpr auto join_all(const SequenceBytes<A> &a, const SequenceBytes<B> &b, const Rest &...rest) {
+  return join_all(join(a, b), rest...);
+}
+
+}  // namespace sequence_detail
+
+// A command and its arguments.
+template<typename... Args> constexpr SequenceBytes<2 + sizeof...(Args)> cmd(int command, Args... args) {
+  static_assert(sizeof...(Args) <= ARG_COUNT_MASK, "Too many arguments for one command");
+  return {{sequence_detail::to_byte(command), static_cast<uint8_t>(sizeof...(Args)),
+           sequence_detail::to_byte(args)...}};
+}
+
+// A command followed by a pause of delay_ms (up to 255).
+template<typename... Args>
+constexpr SequenceBytes<3 + sizeof...(Args)> cmd_delay(int command, int delay_ms, Args... args) {
+  static_assert(sizeof...(Args) <= ARG_COUNT_MASK, "Too many arguments for one command");
+  return {{sequence_detail::to_byte(command), static_cast<uint8_t>(sizeof...(Args) | DELAY_FLAG),
+           sequence_detail::to_byte(delay_ms), sequence_detail::to_byte(args)...}};
+}
+
+// A command followed by a wait for BUSY to go low.
+template<typename... Args> constexpr SequenceBytes<2 + sizeof...(Args)> cmd_wait_busy(int command, Args... args) {
+  static_assert(sizeof...(Args) <= ARG_COUNT_MASK, "Too many arguments for one command");
+  return {{sequence_detail::to_byte(command), static_cast<uint8_t>(sizeof...(Args) | WAIT_BUSY_FLAG),
+           sequence_detail::to_byte(args)...}};
+}
+
+// Entries, or parts built with sequence_part(), joined without an end marker.
+template<typename... Parts> constexpr auto sequence_part(const Parts &...parts) {
+  return sequence_detail::join_all(parts...);
+}
+
+// A complete sequence, ready for CrowPanelEPaperBase::start_sequence_().
+template<typename... Parts> constexpr auto make_sequence(const Parts &...parts) {
+  return sequence_detail::join_all(parts..., SequenceBytes<2>{{COMMAND_END_MARKER, COMMAND_END_MARKER}});
+}
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
@@ -0,0 +1,169 @@
+#include "crowpanel_transport.h"
+#include "esphome/core/gpio.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+
+#include <cstring>
+#endif
+
+namespace esphome {
+namespace crowpanel_epaper {
+
+static const char *const TAG = "crowpanel_epaper.transport";
+
+// ========================================================
+// SoftSPITransport
+// ========================================================
+
+bool SoftSPITransport::setup() {
+  this->clk_pin_->setup();
+  this->clk_pin_->digital_write(false);  // Clock low initially
+  this->mosi_pin_->setup();
+  return true;
+}
+
+void SoftSPITransport::dump_config() {
+  ESP_LOGCONFIG(TAG, "  Transport: Software SPI");
+  LOG_PIN("  CLK Pin: ", this->clk_pin_);
+  LOG_PIN("  MOSI Pin: ", this->mosi_pin_);
+}
+
+void SoftSPITransport::write_byte(uint8_t data) {
+  for (uint8_t i = 0; i < 8; i++) {
+    this->clk_pin_->digital_write(false);  // SCK Low
+    this->mosi_pin_->digital_write(data & 0x80);
+    this->clk_pin_->digital_write(true);  // SCK High (Clock in data)
+    data <<= 1;                           // Shift next bit into position
+  }
+}
+
+// ========================================================
+// ESP32SPITransport
+// ========================================================
+
+#ifdef USE_ESP32
+
+static const spi_host_device_t SPI_HOST_ID = SPI2_HOST;
+
+bool ESP32SPITransport::setup() {
+  spi_bus_config_t bus_config{};
+  bus_config.mosi_io_num = this->mosi_pin_->get_pin();
+  bus_config.miso_io_num = -1;
+  bus_config.sclk_io_num = this->clk_pin_->get_pin();
+  bus_config.quadwp_io_num = -1;
+  bus_config.quadhd_io_num = -1;
+  bus_config.max_transfer_sz = DMA_CHUNK_SIZE;
+  esp_err_t err = spi_bus_initialize(SPI_HOST_ID, &bus_config, SPI_DMA_CH_AUTO);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  spi_device_interface_config_t device_config{};
+  device_config.mode = 0;
+  device_config.clock_speed_hz = this->data_rate_;
+  device_config.spics_io_num = -1;  // CS is driven by the display together with D/C
+  device_config.queue_size = 2;
+  err = spi_bus_add_device(SPI_HOST_ID, &device_config, &this->device_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(err));
+    this->device_ = nullptr;
+    spi_bus_free(SPI_HOST_ID);
+    return false;
+  }
+
+  for (auto &buffer : this->dma_buffer_)
+    buffer = static_cast<uint8_t *>(heap_caps_malloc(DMA_CHUNK_SIZE, MALLOC_CAP_DMA));
+  if (this->dma_buffer_[0] == nullptr || this->dma_buffer_[1] == nullptr) {
+    ESP_LOGW(TAG, "Failed to allocate DMA buffers, sending byte by byte");
+    for (auto &buffer : this->dma_buffer_) {
+      heap_caps_free(buffer);
+      buffer = nullptr;
+    }
+  }
+  return true;
+}
+
+void ESP32SPITransport::dump_config() {
+  ESP_LOGCONFIG(TAG, "  Transport: Hardware SPI (DMA)");
+  LOG_PIN("  CLK Pin: ", this->clk_pin_);
+  LOG_PIN("  MOSI Pin: ", this->mosi_pin_);
+  ESP_LOGCONFIG(TAG, "  Data Rate: %u Hz", this->data_rate_);
+  if (this->device_ == nullptr)
+    ESP_LOGE(TAG, "  SPI device setup failed!");
+  else if (this->dma_buffer_[0] == nullptr)
+    ESP_LOGCONFIG(TAG, "  DMA: unavailable, polled transfers");
+}
+
+void ESP32SPITransport::wait_for_(uint8_t slot) {
+  while (this->in_flight_[slot]) {
+    spi_transaction_t *done;
+    if (spi_device_get_trans_result(this->device_, &done, portMAX_DELAY) != ESP_OK)
+      break;
+    // Results come back in queue order, so this may complete the other slot first.
+    for (uint8_t i = 0; i < 2; i++) {
+      if (done == &this->transactions_[i])
+        this->in_flight_[i] = false;
+    }
+  }
+}
+
+void ESP32SPITransport::flush() {
+  if (this->device_ == nullptr)
+    return;
+  this->wait_for_(0);
+  this->wait_for_(1);
+}
+
+void ESP32SPITransport::write_byte(uint8_t data) {
+  if (this->device_ == nullptr)
+    return;
+  this->flush();
+  spi_transaction_t transaction{};
+  transaction.flags = SPI_TRANS_USE_TXDATA;
+  transaction.length = 8;
+  transaction.tx_data[0] = data;
+  spi_device_polling_transmit(this->device_, &transaction);
+}
+
+void ESP32SPITransport::write_array(const uint8_t *data, size_t len) {
+  if (this->device_ == nullptr || this->dma_buffer_[0] == nullptr) {
+    CrowPanelTransport::write_array(data, len);
+    return;
+  }
+  if (len <= 4) {
+    // Not worth a DMA descriptor.
+    for (size_t i = 0; i < len; i++)
+      this->write_byte(data[i]);
+    return;
+  }
+
+  while (len > 0) {
+    const size_t chunk = len < DMA_CHUNK_SIZE ? len : DMA_CHUNK_SIZE;
+    const uint8_t slot = this->next_slot_;
+    this->wait_for_(slot);
+    memcpy(this->dma_buffer_[slot], data, chunk);
+
+    spi_transaction_t &transaction = this->transactions_[slot];
+    transaction = {};
+    transaction.length = chunk * 8;
+    transaction.tx_buffer = this->dma_buffer_[slot];
+    if (spi_device_queue_trans(this->device_, &transaction, portMAX_DELAY) != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to queue SPI transaction");
+      return;
+    }
+    this->in_flight_[slot] = true;
+    this->next_slot_ = slot ^ 1;
+
+    data += chunk;
+    len -= chunk;
+  }
+}
+
+#endif  // USE_ESP32
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
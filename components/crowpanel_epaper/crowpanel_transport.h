@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef USE_ESP32
+#include <driver/spi_master.h>
+#endif
+
+namespace esphome {
+
+class InternalGPIOPin;
+
+namespace crowpanel_epaper {
+
+// Byte transport used to clock data into the SSD1683.
+// Chip select and D/C stay with the display; a transport only owns CLK/MOSI. This keeps
+// the interface free of any ESPHome types so it can be replaced by a recording mock.
+class CrowPanelTransport {
+ public:
+  virtual ~CrowPanelTransport() = default;
+
+  // Returns false if the transport can't be used, the owner then marks itself failed.
+  virtual bool setup() = 0;
+  virtual void dump_config() = 0;
+
+  virtual void write_byte(uint8_t data) = 0;
+  virtual void write_array(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+      this->write_byte(data[i]);
+  }
+  // Block until every byte handed to the transport is on the wire. Must be called before
+  // CS or D/C change.
+  virtual void flush() {}
+  // Bytes per microsecond the wire takes, for transports whose writes return before the bytes
+  // are out. 0 if writes block until they are sent, then timing them gives the rate.
+  virtual float wire_rate() const { return 0.0f; }
+};
+
+// Bit-banged SPI on any two output pins. Three pin writes per bit.
+class SoftSPITransport : public CrowPanelTransport {
+ public:
+  SoftSPITransport(InternalGPIOPin *clk_pin, InternalGPIOPin *mosi_pin) : clk_pin_(clk_pin), mosi_pin_(mosi_pin) {}
+
+  bool setup() override;
+  void dump_config() override;
+  void write_byte(uint8_t data) override;
+
+ protected:
+  InternalGPIOPin *clk_pin_;
+  InternalGPIOPin *mosi_pin_;
+};
+
+#ifdef USE_ESP32
+// ESP32 SPI master with DMA. Large writes are copied into two DMA-capable bounce buffers and
+// queued, so the last chunk of a frame is still shifting out when write_array() returns.
+// Without DMA buffers every byte is a polled transaction. Uses SPI2, so there can only be one.
+class ESP32SPITransport : public CrowPanelTransport {
+ public:
+  ESP32SPITransport(InternalGPIOPin *clk_pin, InternalGPIOPin *mosi_pin, uint32_t data_rate)
+      : clk_pin_(clk_pin), mosi_pin_(mosi_pin), data_rate_(data_rate) {}
+
+  bool setup() override;
+  void dump_config() override;
+  void write_byte(uint8_t data) override;
+  void write_array(const uint8_t *data, size_t len) override;
+  void flush() override;
+  // Only DMA writes return early, polled ones block.
+  float wire_rate() const override { return this->dma_buffer_[0] != nullptr ? this->data_rate_ / 8e6f : 0.0f; }
+
+ protected:
+  static const size_t DMA_CHUNK_SIZE = 4092;
+
+  void wait_for_(uint8_t slot);
+
+  InternalGPIOPin *clk_pin_;
+  InternalGPIOPin *mosi_pin_;
+  uint32_t data_rate_;
+
+  spi_device_handle_t device_{nullptr};
+  uint8_t *dma_buffer_[2]{nullptr, nullptr};
+  spi_transaction_t transactions_[2]{};
+  bool in_flight_[2]{false, false};
+  uint8_t next_slot_{0};
+};
+#endif  // USE_ESP32
+
+}  // namespace crowpanel_epaper
+}  // namespace esphome
@@ -1,28 +1,80 @@
-from esphome import core, pins
+from esphome import automation, core, pins
 import esphome.codegen as cg
-from esphome.components import display
+from esphome.components import display, globals as globals_, sensor, text_sensor, time
 import esphome.config_validation as cv
 from esphome.const import (
     CONF_BUSY_PIN,
     CONF_DC_PIN,
     CONF_CS_PIN,
+    CONF_END,
     CONF_ID,
     CONF_FULL_UPDATE_EVERY,
+    CONF_HOUR,
+    CONF_INTERVAL,
     CONF_LAMBDA,
+    CONF_MINUTE,
+    CONF_MODE,
     CONF_MODEL,
     CONF_PAGES,
+    CONF_PRIORITY,
     CONF_RESET_DURATION,
     CONF_RESET_PIN,
-    CONF_CLK_PIN,
-    CONF_MOSI_PIN,
+    CONF_PAGE_ID,
     CONF_ROTATION,
+    CONF_SENSORS,
+    CONF_START,
+    CONF_TIME_ID,
+    DEVICE_CLASS_DURATION,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
 )
+from esphome.core import CORE
+
+from . import (
+    CONF_BUS_ID,
+    TRANSPORT_SCHEMA,
+    CrowPanelBus,
+    crowpanel_epaper_ns,
+    final_validate_transport,
+    new_transport,
+    validate_transport,
+)
+
+CONF_SKIPPED_UPDATES = "skipped_updates"
+CONF_REFRESHES = "refreshes"
+CONF_DOUBLE_BUFFER = "double_buffer"
+CONF_SLEEP_BETWEEN_UPDATES = "sleep_between_updates"
+CONF_SPLIT_LAYOUT = "split_layout"
+CONF_PAGE_CACHE = "page_cache"
+CONF_BACKGROUND = "background"
+CONF_MIN_UPDATE_INTERVAL = "min_update_interval"
+CONF_MAX_REFRESHES_PER_HOUR = "max_refreshes_per_hour"
+CONF_WATCH = "watch"
+CONF_TEXT_SENSORS = "text_sensors"
+CONF_GLOBALS = "globals"
+CONF_TIME_GRANULARITY = "time_granularity"
+CONF_SEND_BUDGET = "send_budget"
+CONF_UPLOAD_THROUGHPUT = "upload_throughput"
+CONF_BUS_BYTES = "bus_bytes"
+CONF_UPDATE_MODE = "update_mode"
+CONF_TEMPERATURE_SENSOR = "temperature_sensor"
+CONF_FAST_LUT = "fast_lut"
+CONF_FAST_LUT_ID = "fast_lut_id"
+CONF_FULL_UPDATE_CHURN = "full_update_churn"
+CONF_FULL_UPDATE_MAX_INTERVAL = "full_update_max_interval"
+CONF_REGIONAL_FULL_UPDATE = "regional_full_update"
+CONF_QUIET_HOURS = "quiet_hours"
+
+UNIT_KILOBYTES_PER_SECOND = "kB/s"
+UNIT_BYTES = "B"
 
-crowpanel_epaper_ns = cg.esphome_ns.namespace("crowpanel_epaper")
 CrowPanelEPaperBase = crowpanel_epaper_ns.class_(
     "CrowPanelEPaperBase", display.DisplayBuffer
 )
 CrowPanelEPaper = crowpanel_epaper_ns.class_("CrowPanelEPaper", CrowPanelEPaperBase)
+CrowPanelEPaperRef = CrowPanelEPaper.operator("ref")
 
 CrowPanelEPaper4P2In = crowpanel_epaper_ns.class_(
     "CrowPanelEPaper4P2In", CrowPanelEPaper
@@ -31,20 +83,71 @@ CrowPanelEPaper5P79In = crowpanel_epaper_ns.class_(
     "CrowPanelEPaper5P79In", CrowPanelEPaper
 )
 
+InvalidatePageCacheAction = crowpanel_epaper_ns.class_(
+    "InvalidatePageCacheAction", automation.Action
+)
+RequestUpdateAction = crowpanel_epaper_ns.class_(
+    "RequestUpdateAction", automation.Action
+)
+
+UpdatePhase = crowpanel_epaper_ns.enum("UpdatePhase", is_class=True)
+UpdateMode = crowpanel_epaper_ns.enum("UpdateMode", is_class=True)
+UpdatePriority = crowpanel_epaper_ns.enum("UpdatePriority", is_class=True)
+
+UPDATE_MODES = {
+    "FULL": UpdateMode.FULL,
+    "PARTIAL": UpdateMode.PARTIAL,
+    "FAST": UpdateMode.FAST,
+}
+
+UPDATE_PRIORITIES = {
+    "ROUTINE": UpdatePriority.ROUTINE,
+    "URGENT": UpdatePriority.URGENT,
+}
+
+# SSD1683 waveform registers, optionally followed by EOPT, gate, source (3) and VCOM bytes
+LUT_SIZE = 227
+LUT_SIZE_WITH_VOLTAGES = LUT_SIZE + 6
+
 MODELS = {
     "4.20in": CrowPanelEPaper4P2In,
     "5.79in": CrowPanelEPaper5P79In,
 }
 
+# Per-update duration sensors, one per pipeline phase
+PHASE_SENSORS = {
+    "render_time": UpdatePhase.RENDER,
+    "wake_time": UpdatePhase.WAKE,
+    "busy_wait_time": UpdatePhase.WAIT_BUSY,
+    "prepare_time": UpdatePhase.PREPARE,
+    "send_time": UpdatePhase.SEND,
+    "refresh_time": UpdatePhase.REFRESH,
+    "loop_time": UpdatePhase.LOOP,
+}
+
+def _validate_fast_lut(value):
+    value = cv.ensure_list(cv.hex_uint8_t)(value)
+    if len(value) not in (LUT_SIZE, LUT_SIZE_WITH_VOLTAGES):
+        raise cv.Invalid(
+            f"A LUT has {LUT_SIZE} bytes, or {LUT_SIZE_WITH_VOLTAGES} with the voltage settings; got {len(value)}"
+        )
+    return value
+
+
+def _validate_split_layout(config):
+    if config[CONF_SPLIT_LAYOUT] and config[CONF_MODEL] != "5.79in":
+        raise cv.Invalid("split_layout only applies to the 5.79in cascade panel")
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
     display.FULL_DISPLAY_SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(CrowPanelEPaperBase),
-            cv.Required(CONF_CLK_PIN): pins.gpio_output_pin_schema,
-            cv.Required(CONF_MOSI_PIN): pins.gpio_output_pin_schema,
             cv.Required(CONF_CS_PIN): pins.gpio_output_pin_schema,
             cv.Required(CONF_DC_PIN): pins.gpio_output_pin_schema,
             cv.Required(CONF_RESET_PIN): pins.gpio_output_pin_schema,
+            # Any input pin; one on an I/O expander is polled instead of raising an interrupt.
             cv.Required(CONF_BUSY_PIN): pins.gpio_input_pin_schema,
             cv.Required(CONF_MODEL): cv.one_of(*MODELS, lower=True),
             cv.Optional(CONF_RESET_DURATION): cv.All(
@@ -52,11 +155,130 @@ CONFIG_SCHEMA = cv.All(
                 cv.Range(max=core.TimePeriod(milliseconds=500)),
             ),
             cv.Optional(CONF_FULL_UPDATE_EVERY): cv.positive_int,
+            # Fraction of a screen region flipped by partial updates before it's cleaned. Replaces
+            # full_update_every, which is ignored once this is set.
+            cv.Optional(CONF_FULL_UPDATE_CHURN): cv.All(
+                cv.percentage, cv.Range(min=0.01)
+            ),
+            cv.Optional(
+                CONF_FULL_UPDATE_MAX_INTERVAL
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_REGIONAL_FULL_UPDATE, default=False): cv.boolean,
+            cv.Optional(CONF_QUIET_HOURS): cv.Schema(
+                {
+                    cv.GenerateID(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+                    cv.Required(CONF_START): cv.time_of_day,
+                    cv.Required(CONF_END): cv.time_of_day,
+                }
+            ),
+            # Redraw only when something the frame shows changed, and right when it does.
+            cv.Optional(CONF_WATCH): cv.All(
+                cv.Schema(
+                    {
+                        cv.Optional(CONF_SENSORS): cv.ensure_list(
+                            cv.use_id(sensor.Sensor)
+                        ),
+                        cv.Optional(CONF_TEXT_SENSORS): cv.ensure_list(
+                            cv.use_id(text_sensor.TextSensor)
+                        ),
+                        # Also with restore_value, which generates a different class.
+                        cv.Optional(CONF_GLOBALS): cv.ensure_list(
+                            cv.Any(
+                                cv.use_id(globals_.GlobalsComponent),
+                                cv.use_id(globals_.RestoringGlobalsComponent),
+                                cv.use_id(globals_.RestoringGlobalStringComponent),
+                            )
+                        ),
+                        cv.Inclusive(CONF_TIME_ID, "time"): cv.use_id(
+                            time.RealTimeClock
+                        ),
+                        cv.Inclusive(CONF_TIME_GRANULARITY, "time"): cv.All(
+                            cv.positive_time_period_seconds,
+                            cv.Range(min=core.TimePeriod(seconds=1)),
+                        ),
+                        # Globals and the time have no callbacks, they are polled.
+                        cv.Optional(
+                            CONF_INTERVAL, default="1s"
+                        ): cv.positive_time_period_milliseconds,
+                    }
+                ),
+                cv.has_at_least_one_key(
+                    CONF_SENSORS, CONF_TEXT_SENSORS, CONF_GLOBALS, CONF_TIME_ID
+                ),
+            ),
+            **TRANSPORT_SCHEMA,
+            # Instead of CLK/MOSI of its own, share them with other panels.
+            cv.Optional(CONF_BUS_ID): cv.use_id(CrowPanelBus),
+            cv.Optional(CONF_UPDATE_MODE): cv.enum(UPDATE_MODES, upper=True),
+            # Limits for routine updates, urgent requests ignore them.
+            cv.Optional(
+                CONF_MIN_UPDATE_INTERVAL
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_REFRESHES_PER_HOUR): cv.int_range(min=1, max=3600),
+            # Picks the waveform for FAST updates, the panel's own sensor can't be read back.
+            cv.Optional(CONF_TEMPERATURE_SENSOR): cv.use_id(sensor.Sensor),
+            cv.Optional(CONF_FAST_LUT): _validate_fast_lut,
+            cv.GenerateID(CONF_FAST_LUT_ID): cv.declare_id(cg.uint8),
+            cv.Optional(CONF_DOUBLE_BUFFER, default=False): cv.boolean,
+            cv.Optional(CONF_SLEEP_BETWEEN_UPDATES, default=False): cv.boolean,
+            # One contiguous framebuffer plane per controller, uploaded as a single run each.
+            cv.Optional(CONF_SPLIT_LAYOUT, default=False): cv.boolean,
+            # One frame per page, in PSRAM when there is some, reused when switching back to it.
+            # A cached page keeps showing the values it was drawn with: list what it shows under
+            # `watch`, or call crowpanel_epaper.invalidate_page_cache when it changes.
+            cv.Optional(CONF_PAGE_CACHE, default=False): cv.boolean,
+            # Drawn once and kept, every frame starts from it.
+            cv.Optional(CONF_BACKGROUND): cv.lambda_,
+            # Streaming time per loop(); the rest of the loop is left to WiFi and the API.
+            cv.Optional(CONF_SEND_BUDGET, default="4ms"): cv.All(
+                cv.positive_time_period_microseconds,
+                cv.Range(
+                    min=core.TimePeriod(microseconds=500),
+                    max=core.TimePeriod(milliseconds=30),
+                ),
+            ),
+            cv.Optional(CONF_SKIPPED_UPDATES): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_REFRESHES): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_BUS_BYTES): sensor.sensor_schema(
+                unit_of_measurement=UNIT_BYTES,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_UPLOAD_THROUGHPUT): sensor.sensor_schema(
+                unit_of_measurement=UNIT_KILOBYTES_PER_SECOND,
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+        }
+    ).extend(
+        {
+            cv.Optional(key): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=1,
+                device_class=DEVICE_CLASS_DURATION,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in PHASE_SENSORS
         }
     ),
     cv.has_at_most_one_key(CONF_PAGES, CONF_LAMBDA),
+    validate_transport,
+    _validate_split_layout,
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_transport
+
 async def to_code(config):
     model_class = MODELS[config[CONF_MODEL]]
 
@@ -64,25 +286,81 @@ async def to_code(config):
     var = cg.Pvariable(config[CONF_ID], rhs, model_class)
     
     # Configure pins
-    clk_pin_expr = await cg.gpio_pin_expression(config[CONF_CLK_PIN])
-    mosi_pin_expr = await cg.gpio_pin_expression(config[CONF_MOSI_PIN])
     cs_pin_expr = await cg.gpio_pin_expression(config[CONF_CS_PIN])
     dc_pin_expr = await cg.gpio_pin_expression(config[CONF_DC_PIN])
     reset_pin_expr = await cg.gpio_pin_expression(config[CONF_RESET_PIN])
     busy_pin_expr = await cg.gpio_pin_expression(config[CONF_BUSY_PIN])
     
-    cg.add(var.set_clk_pin(clk_pin_expr))
-    cg.add(var.set_mosi_pin(mosi_pin_expr))
+    if CONF_BUS_ID in config:
+        bus = await cg.get_variable(config[CONF_BUS_ID])
+        cg.add(var.set_bus(bus))
+    else:
+        transport = await new_transport(config)
+        cg.add(var.set_transport(transport))
     cg.add(var.set_cs_pin(cs_pin_expr))
     cg.add(var.set_dc_pin(dc_pin_expr))
     cg.add(var.set_reset_pin(reset_pin_expr))
     cg.add(var.set_busy_pin(busy_pin_expr))
 
-    await display.register_display(var, config)
+    # Pages get a CrowPanelEPaper reference like the display lambda below, so they use the
+    # byte-granular primitives too. display.register_display() would build them on a plain
+    # Display reference, so it only sees the rest of the config.
+    if CONF_PAGES in config:
+        pages = []
+        for conf in config[CONF_PAGES]:
+            lambda_ = await cg.process_lambda(
+                conf[CONF_LAMBDA], [(CrowPanelEPaperRef, "it")], return_type=cg.void
+            )
+            pages.append(cg.new_Pvariable(conf[CONF_ID], var.page_writer(lambda_)))
+        cg.add(var.set_pages(pages))
+
+    await display.register_display(
+        var, {key: value for key, value in config.items() if key != CONF_PAGES}
+    )
 
     # Set full update frequency if specified
     if CONF_FULL_UPDATE_EVERY in config:
         cg.add(var.set_full_update_every(config[CONF_FULL_UPDATE_EVERY]))
+    if CONF_FULL_UPDATE_CHURN in config:
+        cg.add(var.set_full_update_churn(config[CONF_FULL_UPDATE_CHURN]))
+    if CONF_FULL_UPDATE_MAX_INTERVAL in config:
+        cg.add(
+            var.set_full_update_max_interval(
+                config[CONF_FULL_UPDATE_MAX_INTERVAL].total_milliseconds
+            )
+        )
+    cg.add(var.set_regional_full_update(config[CONF_REGIONAL_FULL_UPDATE]))
+    if CONF_QUIET_HOURS in config:
+        quiet = config[CONF_QUIET_HOURS]
+        clock = await cg.get_variable(quiet[CONF_TIME_ID])
+        start = quiet[CONF_START]
+        end = quiet[CONF_END]
+        cg.add(
+            var.set_quiet_hours(
+                clock,
+                start[CONF_HOUR] * 60 + start[CONF_MINUTE],
+                end[CONF_HOUR] * 60 + end[CONF_MINUTE],
+            )
+        )
+    if CONF_WATCH in config:
+        watch = config[CONF_WATCH]
+        for sensor_id in watch.get(CONF_SENSORS, []):
+            sens = await cg.get_variable(sensor_id)
+            cg.add(var.add_watched_sensor(sens))
+        for sensor_id in watch.get(CONF_TEXT_SENSORS, []):
+            sens = await cg.get_variable(sensor_id)
+            cg.add(var.add_watched_text_sensor(sens))
+        for global_id in watch.get(CONF_GLOBALS, []):
+            glob = await cg.get_variable(global_id)
+            cg.add(var.add_watched_global(glob))
+        if CONF_TIME_ID in watch:
+            clock = await cg.get_variable(watch[CONF_TIME_ID])
+            cg.add(
+                var.set_watched_time(
+                    clock, watch[CONF_TIME_GRANULARITY].total_seconds
+                )
+            )
+        cg.add(var.set_watch_interval(watch[CONF_INTERVAL].total_milliseconds))
         
     # Set rotation if specified
     if CONF_ROTATION in config:
@@ -98,9 +376,109 @@ async def to_code(config):
         if rotation_val in display_rotations:
             cg.add(var.set_rotation(display_rotations[rotation_val]))
 
+    if CONF_UPDATE_MODE in config:
+        cg.add(var.set_update_mode(config[CONF_UPDATE_MODE]))
+    if CONF_TEMPERATURE_SENSOR in config:
+        sens = await cg.get_variable(config[CONF_TEMPERATURE_SENSOR])
+        cg.add(var.set_temperature_sensor(sens))
+    if CONF_FAST_LUT in config:
+        lut = cg.progmem_array(config[CONF_FAST_LUT_ID], config[CONF_FAST_LUT])
+        cg.add(var.set_fast_lut(lut, len(config[CONF_FAST_LUT])))
+
+    if config[CONF_DOUBLE_BUFFER]:
+        cg.add(var.set_double_buffer(True))
+    if config[CONF_SLEEP_BETWEEN_UPDATES]:
+        cg.add(var.set_sleep_between_updates(True))
+    if config[CONF_SPLIT_LAYOUT]:
+        cg.add(var.set_split_layout(True))
+    if CONF_MIN_UPDATE_INTERVAL in config:
+        cg.add(
+            var.set_min_update_interval(
+                config[CONF_MIN_UPDATE_INTERVAL].total_milliseconds
+            )
+        )
+    if CONF_MAX_REFRESHES_PER_HOUR in config:
+        cg.add(var.set_max_refreshes_per_hour(config[CONF_MAX_REFRESHES_PER_HOUR]))
+    if config[CONF_PAGE_CACHE]:
+        cg.add(var.set_page_cache(True))
+    cg.add(var.set_send_budget(config[CONF_SEND_BUDGET].total_microseconds))
+
+    if CONF_SKIPPED_UPDATES in config:
+        sens = await sensor.new_sensor(config[CONF_SKIPPED_UPDATES])
+        cg.add(var.set_skipped_updates_sensor(sens))
+    if CONF_REFRESHES in config:
+        sens = await sensor.new_sensor(config[CONF_REFRESHES])
+        cg.add(var.set_refreshes_sensor(sens))
+    if CONF_UPLOAD_THROUGHPUT in config:
+        sens = await sensor.new_sensor(config[CONF_UPLOAD_THROUGHPUT])
+        cg.add(var.set_upload_throughput_sensor(sens))
+    if CONF_BUS_BYTES in config:
+        sens = await sensor.new_sensor(config[CONF_BUS_BYTES])
+        cg.add(var.set_bus_bytes_sensor(sens))
+    for key, phase in PHASE_SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(var.set_phase_sensor(phase, sens))
+
+    # Fonts are blitted directly into the buffer when the font component is in use
+    if "font" in CORE.loaded_integrations:
+        cg.add_define("USE_CROWPANEL_EPAPER_FONT")
+
     # Process lambda for drawing
     if CONF_LAMBDA in config:
         lambda_ = await cg.process_lambda(
-            config[CONF_LAMBDA], [(display.DisplayRef, "it")], return_type=cg.void
+            config[CONF_LAMBDA], [(CrowPanelEPaperRef, "it")], return_type=cg.void
         )
-        cg.add(var.set_writer(lambda_))
+        cg.add(var.set_panel_writer(lambda_))
+    if CONF_BACKGROUND in config:
+        lambda_ = await cg.process_lambda(
+            config[CONF_BACKGROUND], [(CrowPanelEPaperRef, "it")], return_type=cg.void
+        )
+        cg.add(var.set_background_writer(lambda_))
+
+
+@automation.register_action(
+    "crowpanel_epaper.invalidate_page_cache",
+    InvalidatePageCacheAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(CrowPanelEPaperBase),
+            cv.Optional(CONF_PAGE_ID): cv.templatable(
+                cv.use_id(display.DisplayPage)
+            ),
+        }
+    ),
+)
+async def invalidate_page_cache_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    if CONF_PAGE_ID in config:
+        page = config[CONF_PAGE_ID]
+        if isinstance(page, core.Lambda):
+            page = await cg.templatable(page, args, display.DisplayPagePtr)
+        else:
+            page = await cg.get_variable(page)
+        cg.add(var.set_page(page))
+    return var
+
+
+@automation.register_action(
+    "crowpanel_epaper.request_update",
+    RequestUpdateAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(CrowPanelEPaperBase),
+            cv.Optional(CONF_PRIORITY, default="ROUTINE"): cv.enum(
+                UPDATE_PRIORITIES, upper=True
+            ),
+            cv.Optional(CONF_MODE): cv.enum(UPDATE_MODES, upper=True),
+        }
+    ),
+)
+async def request_update_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
+    if CONF_MODE in config:
+        cg.add(var.set_mode(config[CONF_MODE]))
+    return var
@@ -0,0 +1,293 @@
+// Host benchmark of the drawing primitives, text, a dashboard frame and whole updates.
+//
+//   bench [--quick] [--save FILE] [--compare FILE [--threshold PCT]]
+//
+// Prints one CSV line per case (name,ops,ns_op,px_s,glyphs_s), timed on the host's clock and best
+// of three runs. --save writes them as a baseline; --compare reads one and exits with 1 if a case got more
+// than PCT percent (default 10) slower.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "font_loader.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+namespace {
+
+struct Result {
+  std::string name;
+  uint32_t ops;
+  double ns_op;
+  double px_s;
+  double glyphs_s;
+};
+
+// Drops every byte, so whole updates measure the driver alone.
+class NullTransport : public crowpanel_epaper::CrowPanelTransport {
+ public:
+  bool setup() override { return true; }
+  void dump_config() override {}
+  void write_byte(uint8_t data) override {}
+  void write_array(const uint8_t *data, size_t len) override {}
+};
+
+// A panel with nothing behind its pins, updates finish as fast as the driver can go.
+struct BenchPanel {
+  BenchPanel() {
+    host::reset();
+    this->panel.set_cs_pin(&this->cs);
+    this->panel.set_dc_pin(&this->dc);
+    this->panel.set_reset_pin(&this->reset);
+    this->panel.set_transport(&this->transport);
+    this->panel.set_update_interval(UINT32_MAX);
+    this->runner.add(&this->panel);
+  }
+  bool start() {
+    this->runner.setup();
+    return this->runner.run_until([this]() { return this->panel.is_idle(); }, 5000);
+  }
+  void update(crowpanel_epaper::UpdateMode mode) {
+    this->panel.request_update(crowpanel_epaper::UpdatePriority::URGENT, mode);
+    this->runner.run_until([this]() { return this->panel.is_idle(); }, 120000);
+  }
+
+  MockPin cs{45, "cs", true};
+  MockPin dc{46, "dc", true};
+  MockPin reset{47, "reset", true};
+  NullTransport transport;
+  TestPanel<crowpanel_epaper::CrowPanelEPaper4P2In> panel;
+  host::Runner runner;
+};
+
+struct Fonts {
+  std::unique_ptr<LoadedFont> small, large, icons;
+};
+
+// What a typical weather dashboard lambda draws, with the numbers moving with `step`.
+void draw_dashboard(CrowPanelEPaper &it, Fonts &fonts, uint32_t step) {
+  const int w = it.get_width();
+  it.filled_rectangle(0, 0, w, 40);
+  it.horizontal_line(0, 150, w);
+  it.vertical_line(w / 2, 150, it.get_height() - 150);
+  for (int i = 0; i < 4; i++)
+    it.rectangle(10 + i * 95, 200, 85, 80);
+  if (fonts.small == nullptr)
+    return;
+  it.print(10, 8, fonts.small->get(), display::COLOR_OFF, display::TextAlign::TOP_LEFT, "Living room");
+  it.printf(w / 2, 95, fonts.large->get(), display::TextAlign::CENTER, "%02u:%02u", (step / 60) % 24, step % 60);
+  it.printf(w / 4, 170, fonts.small->get(), display::TextAlign::TOP_CENTER, "%.1f C", 20.0f + (step % 50) / 10.0f);
+  it.printf(3 * w / 4, 170, fonts.small->get(), display::TextAlign::TOP_CENTER, "%u %%", 40 + step % 20);
+  if (fonts.icons != nullptr) {
+    static const char *const ICONS[] = {"\U000F0599", "\U000F0590", "\U000F050F", "\U000F058E"};
+    for (int i = 0; i < 4; i++)
+      it.print(52 + i * 95, 240, fonts.icons->get(), display::TextAlign::CENTER, ICONS[(i + step) % 4]);
+  }
+}
+
+class Bench {
+ public:
+  explicit Bench(bool quick) : scale_(quick ? 10 : 1) {}
+
+  // Runs `body(i)` for `ops` iterations, best of three. `pixels` and `glyphs` are per op.
+  template<typename F> void run(const std::string &name, uint32_t ops, uint64_t pixels, F &&body) {
+    this->run(name, ops, pixels, 0, body);
+  }
+  template<typename F> void run(const std::string &name, uint32_t ops, uint64_t pixels, uint32_t glyphs, F &&body) {
+    ops = std::max<uint32_t>(1, ops / this->scale_);
+    double best_ns = 0;
+    for (int rep = 0; rep < 3; rep++) {
+      const auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < ops; i++)
+        body(i);
+      const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      if (rep == 0 || ns < best_ns)
+        best_ns = ns;
+    }
+    const double ns_op = best_ns / ops;
+    const Result result{name, ops, ns_op, pixels * 1e9 / ns_op, glyphs * 1e9 / ns_op};
+    this->results_.push_back(result);
+    printf("%s,%u,%.1f,%.0f,%.0f\n", name.c_str(), ops, ns_op, result.px_s, result.glyphs_s);
+    fflush(stdout);
+  }
+
+  const std::vector<Result> &results() const { return this->results_; }
+
+ protected:
+  uint32_t scale_;
+  std::vector<Result> results_;
+};
+
+bool save(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream out(path);
+  out << "name,ops,ns_op,px_s,glyphs_s\n";
+  for (const auto &r : results)
+    out << r.name << "," << r.ops << "," << r.ns_op << "," << r.px_s << "," << r.glyphs_s << "\n";
+  return out.good();
+}
+
+bool load(const std::string &path, std::map<std::string, double> *ns_op) {
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  std::getline(in, line);  // Header
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string name, ops, ns;
+    if (std::getline(fields, name, ',') && std::getline(fields, ops, ',') && std::getline(fields, ns, ','))
+      (*ns_op)[name] = atof(ns.c_str());
+  }
+  return true;
+}
+
+// Prints each case against the baseline. Returns the number of regressions.
+int compare(const std::map<std::string, double> &baseline, const std::vector<Result> &results, double threshold) {
+  int regressions = 0;
+  fprintf(stderr, "%-28s %12s %12s %8s\n", "case", "baseline ns", "ns", "change");
+  for (const auto &r : results) {
+    auto it = baseline.find(r.name);
+    if (it == baseline.end() || it->second <= 0) {
+      fprintf(stderr, "%-28s %12s %12.1f %8s\n", r.name.c_str(), "-", r.ns_op, "new");
+      continue;
+    }
+    const double change = (r.ns_op / it->second - 1.0) * 100.0;
+    const bool regressed = change > threshold;
+    regressions += regressed;
+    fprintf(stderr, "%-28s %12.1f %12.1f %+7.1f%%%s\n", r.name.c_str(), it->second, r.ns_op, change,
+            regressed ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool quick = false;
+  std::string save_path, compare_path;
+  double threshold = 10.0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      save_path = argv[++i];
+    } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+      compare_path = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--quick] [--save FILE] [--compare FILE [--threshold PCT]]\n", argv[0]);
+      return 2;
+    }
+  }
+  std::map<std::string, double> baseline;
+  if (!compare_path.empty() && !load(compare_path, &baseline)) {
+    fprintf(stderr, "Could not read %s\n", compare_path.c_str());
+    return 2;
+  }
+  host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+
+  Fonts fonts;
+  const auto chars = ascii_chars();
+  fonts.small = load_font(font_path("OpenSans-Medium.ttf"), 20, chars);
+  fonts.large = load_font(font_path("OpenSans-Bold.ttf"), 64, chars);
+  fonts.icons = load_font(font_path("materialdesignicons-webfont.ttf"), 48,
+                          {"\U000F0599", "\U000F0590", "\U000F050F", "\U000F058E"});
+  if (fonts.small == nullptr || fonts.large == nullptr)
+    fprintf(stderr, "No fonts (built without FreeType?), text cases skipped\n");
+
+  BenchPanel bench_panel;
+  auto &panel = bench_panel.panel;
+  if (!bench_panel.start()) {
+    fprintf(stderr, "Panel did not initialize\n");
+    return 2;
+  }
+
+  Bench bench(quick);
+  printf("name,ops,ns_op,px_s,glyphs_s\n");
+  static const char *const ROTATION_NAMES[] = {"pixel_rot0", "pixel_rot90", "pixel_rot180", "pixel_rot270"};
+  for (int r = 0; r < 4; r++) {
+    panel.set_rotation(static_cast<display::DisplayRotation>(r * 90));
+    const int w = panel.get_width();
+    const int h = panel.get_height();
+    bench.run(ROTATION_NAMES[r], 200000, 1, [&](uint32_t i) {
+      panel.draw_pixel_at(i % w, (i / w) % h, (i & 1) ? display::COLOR_ON : display::COLOR_OFF);
+    });
+  }
+  panel.set_rotation(display::DISPLAY_ROTATION_0_DEGREES);
+  const int w = panel.get_width();
+  const int h = panel.get_height();
+
+  bench.run("fill", 2000, w * h, [&](uint32_t i) { panel.fill((i & 1) ? display::COLOR_ON : display::COLOR_OFF); });
+  bench.run("horizontal_line", 20000, w, [&](uint32_t i) { panel.horizontal_line(0, i % h, w); });
+  bench.run("vertical_line", 20000, h, [&](uint32_t i) { panel.vertical_line(i % w, 0, h); });
+  bench.run("line", 5000, std::max(w, h), [&](uint32_t i) { panel.line(0, i % h, w - 1, h - 1 - i % h); });
+  bench.run("rectangle", 20000, 400, [&](uint32_t i) { panel.rectangle(i % (w - 100), i % (h - 100), 100, 100); });
+  bench.run("filled_rectangle", 5000, 100 * 100,
+            [&](uint32_t i) { panel.filled_rectangle(i % (w - 100), i % (h - 100), 100, 100); });
+
+  if (fonts.small != nullptr) {
+    static const char *const TEXT = "12:34 Temperature 21.5";
+    int x, y, text_w, text_h;
+    panel.get_text_bounds(0, 0, TEXT, fonts.small->get(), display::TextAlign::TOP_LEFT, &x, &y, &text_w, &text_h);
+    bench.run("text_opensans20", 5000, text_w * text_h,
+              [&](uint32_t i) { panel.print(0, i % (h - text_h), fonts.small->get(), TEXT); });
+    panel.get_text_bounds(0, 0, "12:34", fonts.large->get(), display::TextAlign::TOP_LEFT, &x, &y, &text_w, &text_h);
+    bench.run("text_opensans64", 2000, text_w * text_h,
+              [&](uint32_t i) { panel.print(i % 100, i % (h - text_h), fonts.large->get(), "12:34"); });
+  }
+  if (fonts.small != nullptr) {
+    // Glyph throughput of the blitting print() against font::Font::print() drawing pixel by pixel.
+    static const char *const SENTENCE = "The quick brown fox jumps over the lazy dog 0123456789";
+    const uint32_t glyphs = strlen(SENTENCE);
+    int x, y, text_w, text_h;
+    panel.get_text_bounds(0, 0, SENTENCE, fonts.small->get(), display::TextAlign::TOP_LEFT, &x, &y, &text_w, &text_h);
+    bench.run("glyphs_blit", 2000, text_w * text_h, glyphs,
+              [&](uint32_t i) { panel.print(0, i % (h - text_h), fonts.small->get(), SENTENCE); });
+    bench.run("glyphs_upstream", 500, text_w * text_h, glyphs, [&](uint32_t i) {
+      panel.esphome::display::Display::print(0, i % (h - text_h), fonts.small->get(), display::COLOR_ON,
+                                             display::TextAlign::TOP_LEFT, SENTENCE);
+    });
+  }
+  if (fonts.icons != nullptr) {
+    bench.run("icons_mdi48", 5000, 4 * 48 * 48, [&](uint32_t i) {
+      panel.print(i % 100, i % (h - 48), fonts.icons->get(), "\U000F0599\U000F0590\U000F050F\U000F058E");
+    });
+  }
+
+  bench.run("dashboard", 500, w * h, [&](uint32_t i) {
+    panel.fill(display::COLOR_OFF);
+    draw_dashboard(panel, fonts, i);
+  });
+
+  // Whole updates: render, diff, upload and the state machine, with the bus bytes dropped.
+  uint32_t step = 0;
+  panel.set_panel_writer([&](CrowPanelEPaper &it) { draw_dashboard(it, fonts, step); });
+  bench.run("update_full", 50, w * h, [&](uint32_t i) {
+    step++;
+    bench_panel.update(crowpanel_epaper::UpdateMode::FULL);
+  });
+  bench.run("update_partial", 200, w * h, [&](uint32_t i) {
+    step++;
+    bench_panel.update(crowpanel_epaper::UpdateMode::PARTIAL);
+  });
+
+  if (!save_path.empty() && !save(save_path, bench.results())) {
+    fprintf(stderr, "Could not write %s\n", save_path.c_str());
+    return 2;
+  }
+  if (!compare_path.empty() && compare(baseline, bench.results(), threshold) > 0)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include "font_loader.h"
+
+#include <algorithm>
+
+#ifdef CROWPANEL_HOST_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+namespace esphome {
+namespace sim {
+
+std::vector<std::string> ascii_chars() {
+  std::vector<std::string> chars;
+  for (char c = ' '; c <= '~'; c++)
+    chars.emplace_back(1, c);
+  return chars;
+}
+
+std::string font_path(const std::string &name) { return std::string(CROWPANEL_FONT_DIR) + "/" + name; }
+
+#ifdef CROWPANEL_HOST_FREETYPE
+
+namespace {
+
+// Decodes the first code point of a UTF-8 string.
+uint32_t first_code_point(const std::string &str) {
+  const auto *s = reinterpret_cast<const uint8_t *>(str.data());
+  if (s[0] < 0x80)
+    return s[0];
+  if ((s[0] & 0xE0) == 0xC0)
+    return (s[0] & 0x1F) << 6 | (s[1] & 0x3F);
+  if ((s[0] & 0xF0) == 0xE0)
+    return (s[0] & 0x0F) << 12 | (s[1] & 0x3F) << 6 | (s[2] & 0x3F);
+  return (s[0] & 0x07) << 18 | (s[1] & 0x3F) << 12 | (s[2] & 0x3F) << 6 | (s[3] & 0x3F);
+}
+
+}  // namespace
+
+std::unique_ptr<LoadedFont> load_font(const std::string &path, int size, const std::vector<std::string> &chars) {
+  FT_Library library;
+  if (FT_Init_FreeType(&library) != 0)
+    return nullptr;
+  FT_Face face;
+  if (FT_New_Face(library, path.c_str(), 0, &face) != 0) {
+    FT_Done_FreeType(library);
+    return nullptr;
+  }
+  FT_Set_Pixel_Sizes(face, 0, size);
+  const int ascender = face->size->metrics.ascender >> 6;
+  const int descender = face->size->metrics.descender >> 6;
+
+  std::unique_ptr<LoadedFont> loaded(new LoadedFont());
+  std::vector<std::string> sorted = chars;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  struct Metrics {
+    int advance, offset_x, offset_y, width, height;
+  };
+  std::vector<Metrics> metrics;
+  for (const auto &str : sorted) {
+    const FT_UInt index = FT_Get_Char_Index(face, first_code_point(str));
+    if (index == 0 || FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO) != 0)
+      continue;
+    const FT_GlyphSlot slot = face->glyph;
+    const FT_Bitmap &bitmap = slot->bitmap;
+    const int width = bitmap.width;
+    const int height = bitmap.rows;
+    std::vector<uint8_t> bits((width * height + 7) / 8, 0);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        if (bitmap.buffer[y * bitmap.pitch + x / 8] & (0x80 >> (x % 8))) {
+          const int pos = y * width + x;
+          bits[pos / 8] |= 0x80 >> (pos % 8);
+        }
+      }
+    }
+    loaded->chars_.push_back(str);
+    loaded->bitmaps_.push_back(std::move(bits));
+    metrics.push_back({static_cast<int>(slot->advance.x >> 6), slot->bitmap_left, ascender - slot->bitmap_top, width,
+                       height});
+  }
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+
+  // Pointers into the vectors above, which are complete now.
+  for (size_t i = 0; i < metrics.size(); i++) {
+    const Metrics &m = metrics[i];
+    loaded->data_.push_back({reinterpret_cast<const uint8_t *>(loaded->chars_[i].c_str()), loaded->bitmaps_[i].data(),
+                             m.advance, m.offset_x, m.offset_y, m.width, m.height});
+  }
+  for (const auto &data : loaded->data_)
+    loaded->glyphs_.emplace_back(&data);
+  loaded->font_.reset(new font::Font(loaded->glyphs_.data(), loaded->glyphs_.size(), ascender, ascender - descender));
+  return loaded;
+}
+
+#else
+
+std::unique_ptr<LoadedFont> load_font(const std::string &path, int size, const std::vector<std::string> &chars) {
+  return nullptr;
+}
+
+#endif  // CROWPANEL_HOST_FREETYPE
+
+}  // namespace sim
+}  // namespace esphome
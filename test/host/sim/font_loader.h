@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/components/font/font.h"
+
+namespace esphome {
+namespace sim {
+
+// A font::Font rasterized from a TrueType file the way ESPHome's font component does at build
+// time: 1 bit per pixel, glyph bits packed row after row, glyphs sorted by their UTF-8 string,
+// baseline at the ascender.
+class LoadedFont {
+ public:
+  font::Font *get() { return this->font_.get(); }
+  size_t glyph_count() const { return this->data_.size(); }
+
+ protected:
+  friend std::unique_ptr<LoadedFont> load_font(const std::string &path, int size,
+                                               const std::vector<std::string> &chars);
+
+  std::vector<std::string> chars_;
+  std::vector<std::vector<uint8_t>> bitmaps_;
+  std::vector<font::GlyphData> data_;
+  std::vector<font::Glyph> glyphs_;
+  std::unique_ptr<font::Font> font_;
+};
+
+// Loads `chars` (UTF-8, one glyph each) at `size` pixels. Characters missing from the file are
+// left out. nullptr if the file can't be read or the build has no FreeType.
+std::unique_ptr<LoadedFont> load_font(const std::string &path, int size, const std::vector<std::string> &chars);
+
+// The printable ASCII range, one string per character.
+std::vector<std::string> ascii_chars();
+
+// Path of a file in the repository's fonts/ directory.
+std::string font_path(const std::string &name);
+
+}  // namespace sim
+}  // namespace esphome
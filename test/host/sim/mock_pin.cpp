@@ -0,0 +1,47 @@
+#include "mock_pin.h"
+
+#include "host/runtime.h"
+
+namespace esphome {
+namespace sim {
+
+void MockPin::digital_write(bool value) {
+  this->write_count_++;
+  if (this->write_cost_ns_ != 0)
+    host::Clock::advance_ns(this->write_cost_ns_);
+  this->level_ = value;
+  for (auto &listener : this->listeners_)
+    listener(value);
+}
+
+void MockPin::set_input(bool level) {
+  const bool previous = this->level_;
+  this->level_ = level;
+  if (this->isr_ == nullptr)
+    return;
+  bool fire = false;
+  switch (this->isr_type_) {
+    case gpio::INTERRUPT_RISING_EDGE:
+      fire = !previous && level;
+      break;
+    case gpio::INTERRUPT_FALLING_EDGE:
+      fire = previous && !level;
+      break;
+    case gpio::INTERRUPT_ANY_EDGE:
+      fire = previous != level;
+      break;
+    case gpio::INTERRUPT_LOW_LEVEL:
+      fire = !level;
+      break;
+    case gpio::INTERRUPT_HIGH_LEVEL:
+      fire = level;
+      break;
+  }
+  if (fire) {
+    this->interrupt_count_++;
+    this->isr_(this->isr_arg_);
+  }
+}
+
+}  // namespace sim
+}  // namespace esphome
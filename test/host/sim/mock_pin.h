@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/gpio.h"
+
+namespace esphome {
+namespace sim {
+
+// A GPIO the component drives or reads. Writes go to listeners (bus decoders, panel models),
+// inputs are driven with set_input() and fire an attached interrupt on a matching edge, in the
+// caller's context like a real ISR would interrupt the loop.
+class MockPin : public InternalGPIOPin {
+ public:
+  MockPin(uint8_t pin, std::string name, bool level = false) : pin_(pin), name_(std::move(name)), level_(level) {}
+
+  void setup() override { this->setup_count_++; }
+  void pin_mode(gpio::Flags flags) override {}
+  bool digital_read() override { return this->level_; }
+  void digital_write(bool value) override;
+  std::string dump_summary() const override { return "GPIO" + std::to_string(this->pin_) + " (" + this->name_ + ")"; }
+  void detach_interrupt() const override { this->isr_ = nullptr; }
+  ISRInternalGPIOPin to_isr() const override { return ISRInternalGPIOPin(); }
+  uint8_t get_pin() const override { return this->pin_; }
+  bool is_inverted() const override { return false; }
+
+  // Called after every digital_write(), with the new level.
+  void on_write(std::function<void(bool)> &&listener) { this->listeners_.push_back(std::move(listener)); }
+  // Drives the pin from outside.
+  void set_input(bool level);
+  // Virtual time each digital_write() takes, to model the cost of bit-banging.
+  void set_write_cost_ns(uint32_t ns) { this->write_cost_ns_ = ns; }
+
+  bool level() const { return this->level_; }
+  const std::string &name() const { return this->name_; }
+  uint32_t write_count() const { return this->write_count_; }
+  uint32_t setup_count() const { return this->setup_count_; }
+  uint32_t interrupt_count() const { return this->interrupt_count_; }
+  bool has_interrupt() const { return this->isr_ != nullptr; }
+
+ protected:
+  void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const override {
+    this->isr_ = func;
+    this->isr_arg_ = arg;
+    this->isr_type_ = type;
+  }
+
+  uint8_t pin_;
+  std::string name_;
+  bool level_;
+  uint32_t write_cost_ns_{0};
+  uint32_t write_count_{0};
+  uint32_t setup_count_{0};
+  uint32_t interrupt_count_{0};
+  std::vector<std::function<void(bool)>> listeners_;
+  mutable void (*isr_)(void *){nullptr};
+  mutable void *isr_arg_{nullptr};
+  mutable gpio::InterruptType isr_type_{gpio::INTERRUPT_ANY_EDGE};
+};
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "crowpanel_epaper.h"
+#include "host/idf.h"
+#include "host/runtime.h"
+#include "mock_pin.h"
+#include "spi_wire.h"
+#include "ssd1683_sim.h"
+#include "wire_transport.h"
+
+namespace esphome {
+namespace sim {
+
+// A panel model with the driver state tests look at made public.
+template<typename Model> class TestPanel : public Model {
+ public:
+  crowpanel_epaper::EpdState state() const { return this->state_; }
+  // No update running or pending.
+  bool is_idle() const { return this->state_ == crowpanel_epaper::EpdState::IDLE && !this->needs_update_; }
+  uint8_t *buffer() { return this->buffer_; }
+  uint32_t buffer_length() { return this->get_buffer_length_(); }
+  // The frame last handed over for upload.
+  std::vector<uint8_t> transfer_frame() {
+    return std::vector<uint8_t>(this->transfer_buffer_, this->transfer_buffer_ + this->get_buffer_length_());
+  }
+  uint32_t bus_command_bytes() const { return this->bus_bytes_[1]; }
+  uint32_t bus_data_bytes() const { return this->bus_bytes_[0]; }
+  crowpanel_epaper::UpdateMode update_mode() const { return this->update_mode_; }
+  uint32_t refresh_duration_us() const { return this->refresh_duration_us_; }
+  display::DisplayRotation rotation() const { return this->rotation_; }
+  bool background_valid() const { return this->background_valid_; }
+  // Regions re-driven by the last regional cleaning update.
+  const crowpanel_epaper::RamWindow &clean_window() const { return this->clean_window_; }
+  bool page_cached(const display::DisplayPage *page) const {
+    for (const auto &entry : this->page_cache_entries_) {
+      if (entry.page == page)
+        return entry.valid;
+    }
+    return false;
+  }
+  const display::DisplayPage *last_drawn_page() const { return this->last_drawn_page_; }
+  // The next frame was rendered ahead of time into the spare buffer.
+  bool frame_ready() const { return this->frame_ready_; }
+  uint32_t drawn_generation() const { return this->drawn_generation_; }
+  // Longest loop() call of the current or last update.
+  uint32_t max_loop_us() const { return this->max_loop_us_; }
+  float send_rate() const { return this->send_rate_; }
+
+  // Pixels drawn one at a time, as the per-pixel display::Display primitives do.
+  uint32_t pixel_calls{0};
+
+ protected:
+  void draw_absolute_pixel_internal(int x, int y, Color color) override {
+    this->pixel_calls++;
+    Model::draw_absolute_pixel_internal(x, y, color);
+  }
+};
+
+// One panel wired up the way the ESP32 drives it: bit-banged CLK/MOSI, CS, D/C, reset and BUSY on
+// mock pins, decoded into a simulated SSD1683. The panel is registered with a runner that stands in for
+// the ESPHome main loop.
+template<typename Model> class PanelRig {
+ public:
+  static constexpr PanelModel MODEL =
+      std::is_same<Model, crowpanel_epaper::CrowPanelEPaper5P79In>::value ? PanelModel::P5P79IN : PanelModel::P4P2IN;
+
+  PanelRig() : sim(MODEL) {
+    host::reset();
+    this->wire.attach_soft_spi(&this->clk, &this->mosi);
+    this->wire.add_panel(&this->sim, &this->cs, &this->dc);
+    this->sim.attach_reset(&this->reset);
+    this->sim.attach_busy(&this->busy);
+    this->panel.set_cs_pin(&this->cs);
+    this->panel.set_dc_pin(&this->dc);
+    this->panel.set_reset_pin(&this->reset);
+    this->panel.set_busy_pin(&this->busy);
+    this->panel.set_transport(&this->transport);
+    // Updates only when a test asks for one.
+    this->panel.set_update_interval(UINT32_MAX);
+    this->runner.add(&this->panel);
+  }
+
+  // Replaces the bit-banged transport, before start().
+  void use_transport(crowpanel_epaper::CrowPanelTransport *transport) { this->panel.set_transport(transport); }
+  // Sends through the (fake) ESP32 SPI master instead, before start().
+  void use_hardware_spi(uint32_t data_rate = 20000000) {
+    this->hardware = std::unique_ptr<crowpanel_epaper::ESP32SPITransport>(
+        new crowpanel_epaper::ESP32SPITransport(&this->clk, &this->mosi, data_rate));
+    host::idf::set_sink([this](const uint8_t *data, size_t len) {
+      for (size_t i = 0; i < len; i++)
+        this->wire.clock_byte(data[i]);
+    });
+    this->use_transport(this->hardware.get());
+  }
+
+  // Runs setup() and the controller initialization.
+  bool start() {
+    this->runner.setup();
+    return this->runner.run_until([this]() { return this->panel.is_idle(); }, 5000);
+  }
+  // Asks for an update and runs the loop until it is done.
+  bool update(uint32_t max_ms = 120000) {
+    this->panel.update();
+    return this->wait_idle(max_ms);
+  }
+  bool wait_idle(uint32_t max_ms = 120000) {
+    return this->runner.run_until([this]() { return this->panel.is_idle(); }, max_ms);
+  }
+
+  // Pins as in esphome.yaml for the CrowPanel boards.
+  MockPin clk{12, "clk"};
+  MockPin mosi{11, "mosi"};
+  MockPin cs{45, "cs", true};
+  MockPin dc{46, "dc", true};
+  MockPin reset{47, "reset", true};
+  MockPin busy{48, "busy"};
+  crowpanel_epaper::SoftSPITransport transport{&clk, &mosi};
+  std::unique_ptr<crowpanel_epaper::ESP32SPITransport> hardware;
+  SpiWire wire;
+  Ssd1683Sim sim;
+  TestPanel<Model> panel;
+  host::Runner runner;
+};
+
+using Rig4P2In = PanelRig<crowpanel_epaper::CrowPanelEPaper4P2In>;
+using Rig5P79In = PanelRig<crowpanel_epaper::CrowPanelEPaper5P79In>;
+
+}  // namespace sim
+}  // namespace esphome
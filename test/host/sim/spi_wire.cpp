@@ -0,0 +1,68 @@
+#include "spi_wire.h"
+
+#include "host/runtime.h"
+
+namespace esphome {
+namespace sim {
+
+static const size_t MAX_ERRORS = 100;
+
+void SpiWire::attach_soft_spi(MockPin *clk, MockPin *mosi) {
+  this->clk_ = clk;
+  this->mosi_ = mosi;
+  this->clk_level_ = clk->level();
+  clk->on_write([this](bool level) { this->on_clk_(level); });
+}
+
+void SpiWire::add_panel(Ssd1683Sim *panel, MockPin *cs, MockPin *dc) {
+  this->slots_.push_back({panel, cs, dc});
+  cs->on_write([this](bool level) { this->on_cs_(level); });
+}
+
+void SpiWire::on_clk_(bool level) {
+  const bool rising = level && !this->clk_level_;
+  this->clk_level_ = level;
+  if (!rising)
+    return;
+  this->shift_ = (this->shift_ << 1) | (this->mosi_->level() ? 1 : 0);
+  if (++this->bit_count_ < 8)
+    return;
+  this->bit_count_ = 0;
+  this->clock_byte(this->shift_);
+}
+
+void SpiWire::on_cs_(bool level) {
+  if (level && this->bit_count_ != 0) {
+    this->error_("CS went high after " + std::to_string(this->bit_count_) + " bits of a byte");
+    this->bit_count_ = 0;
+  }
+}
+
+void SpiWire::clock_byte(uint8_t byte) {
+  this->bytes_++;
+  Slot *selected = nullptr;
+  uint8_t count = 0;
+  for (auto &slot : this->slots_) {
+    if (!slot.cs->level()) {
+      selected = &slot;
+      count++;
+    }
+  }
+  if (count == 0) {
+    this->error_("Byte clocked out with no panel selected");
+    return;
+  }
+  if (count > 1) {
+    this->error_("Byte clocked out with " + std::to_string(count) + " panels selected");
+    return;
+  }
+  selected->panel->receive(byte, selected->dc->level());
+}
+
+void SpiWire::error_(const std::string &message) {
+  if (this->errors_.size() < MAX_ERRORS)
+    this->errors_.push_back("t=" + std::to_string(host::Clock::now_ns() / 1000u) + "us: " + message);
+}
+
+}  // namespace sim
+}  // namespace esphome
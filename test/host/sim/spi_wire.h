@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mock_pin.h"
+#include "ssd1683_sim.h"
+
+namespace esphome {
+namespace sim {
+
+// The CLK/MOSI lines shared by one or more panels, each with its own CS and D/C.
+//
+// Bit-banged traffic is decoded from the pins: MOSI is sampled on the rising CLK edge, MSB first,
+// and every eighth bit hands a byte to the panel whose CS is low, together with the D/C level.
+// Transports that don't bit-bang call clock_byte() instead. Bytes with no CS or several CS lines
+// low, and CS going up in the middle of a byte, are recorded in errors().
+class SpiWire {
+ public:
+  void attach_soft_spi(MockPin *clk, MockPin *mosi);
+  void add_panel(Ssd1683Sim *panel, MockPin *cs, MockPin *dc);
+
+  void clock_byte(uint8_t byte);
+
+  uint64_t byte_count() const { return this->bytes_; }
+  const std::vector<std::string> &errors() const { return this->errors_; }
+
+ protected:
+  struct Slot {
+    Ssd1683Sim *panel;
+    MockPin *cs;
+    MockPin *dc;
+  };
+
+  void on_clk_(bool level);
+  void on_cs_(bool level);
+  void error_(const std::string &message);
+
+  MockPin *clk_{nullptr};
+  MockPin *mosi_{nullptr};
+  bool clk_level_{false};
+  uint8_t shift_{0};
+  uint8_t bit_count_{0};
+  uint64_t bytes_{0};
+  std::vector<Slot> slots_;
+  std::vector<std::string> errors_;
+};
+
+}  // namespace sim
+}  // namespace esphome
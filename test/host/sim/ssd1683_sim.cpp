@@ -0,0 +1,413 @@
+#include "ssd1683_sim.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "host/runtime.h"
+
+namespace esphome {
+namespace sim {
+
+static const uint8_t TARGET_SECONDARY = 0x80;
+static const uint8_t CMD_DEEP_SLEEP = 0x10;
+static const uint8_t CMD_DATA_ENTRY_MODE = 0x11;
+static const uint8_t CMD_SOFT_RESET = 0x12;
+static const uint8_t CMD_DISPLAY_UPDATE = 0x20;
+static const uint8_t CMD_UPDATE_SEQUENCE = 0x22;
+static const uint8_t CMD_WRITE_RAM = 0x24;
+static const uint8_t CMD_WRITE_OLD_RAM = 0x26;
+static const uint8_t CMD_SET_X_ADDR = 0x44;
+static const uint8_t CMD_SET_Y_ADDR = 0x45;
+static const uint8_t CMD_SET_X_COUNTER = 0x4E;
+static const uint8_t CMD_SET_Y_COUNTER = 0x4F;
+
+// Bits of the 0x22 parameter
+static const uint8_t SEQUENCE_DISPLAY = 0x04;
+static const uint8_t SEQUENCE_LOAD_LUT = 0x10;
+
+static const size_t MAX_ERRORS = 100;
+
+// Parameter count of each command the driver may send, -1 for RAM writes.
+static int parameter_count(uint8_t command) {
+  switch (command) {
+    case 0x01:  // Driver output control (MUX)
+    case 0x04:  // Source driving voltage
+      return 3;
+    case 0x03:  // Gate driving voltage
+    case CMD_DEEP_SLEEP:
+    case CMD_DATA_ENTRY_MODE:
+    case CMD_UPDATE_SEQUENCE:
+    case 0x2C:  // VCOM
+    case 0x3C:  // Border waveform
+    case 0x3F:  // End option
+    case CMD_SET_X_COUNTER:
+      return 1;
+    case 0x1A:  // Temperature register
+    case 0x21:  // Display update control
+    case CMD_SET_X_ADDR:
+    case CMD_SET_Y_COUNTER:
+      return 2;
+    case CMD_SET_Y_ADDR:
+      return 4;
+    case CMD_SOFT_RESET:
+    case CMD_DISPLAY_UPDATE:
+      return 0;
+    case 0x32:  // Waveform
+      return 227;
+    case CMD_WRITE_RAM:
+    case CMD_WRITE_OLD_RAM:
+      return -1;
+    default:
+      return -2;
+  }
+}
+
+Ssd1683Sim::Ssd1683Sim(PanelModel model)
+    : model_(model),
+      controller_count_(model == PanelModel::P5P79IN ? 2 : 1),
+      rows_(model == PanelModel::P5P79IN ? 272 : 300) {
+  for (auto &controller : this->controllers_) {
+    // Power-on RAM content is undefined, start from a recognizable pattern instead of white.
+    controller.ram[0].assign(RAM_WIDTH_BYTES * RAM_ROWS, 0xA5);
+    controller.ram[1].assign(RAM_WIDTH_BYTES * RAM_ROWS, 0xA5);
+  }
+  this->reset_registers_();
+}
+
+uint16_t Ssd1683Sim::frame_stride() const {
+  // The controllers share one byte column.
+  return this->controller_count_ * RAM_WIDTH_BYTES - (this->controller_count_ - 1);
+}
+
+Ssd1683Sim::~Ssd1683Sim() { this->end_busy_(); }
+
+void Ssd1683Sim::attach_reset(MockPin *reset) {
+  reset->on_write([this, previous = reset->level()](bool level) mutable {
+    if (!level && previous) {
+      this->in_reset_ = true;
+      this->end_busy_();
+    } else if (level && !previous) {
+      // The registers are back to their defaults, the RAM is kept.
+      this->in_reset_ = false;
+      this->asleep_ = false;
+      this->in_command_ = false;
+      this->hardware_resets_++;
+      this->reset_registers_();
+    }
+    previous = level;
+  });
+}
+
+void Ssd1683Sim::attach_busy(MockPin *busy) {
+  this->busy_ = busy;
+  busy->set_input(false);
+}
+
+void Ssd1683Sim::start_busy_(uint32_t duration_us) {
+  if (this->busy_ == nullptr)
+    return;
+  host::Clock::cancel(this->busy_alarm_);
+  this->busy_->set_input(true);
+  if (this->busy_stuck_)
+    return;
+  this->busy_alarm_ = host::Clock::at(host::Clock::now_ns() + duration_us * 1000ull, [this]() {
+    this->busy_alarm_ = 0;
+    this->busy_->set_input(false);
+  });
+}
+
+void Ssd1683Sim::end_busy_() {
+  if (this->busy_alarm_ != 0)
+    host::Clock::cancel(this->busy_alarm_);
+  this->busy_alarm_ = 0;
+  if (this->busy_ != nullptr)
+    this->busy_->set_input(false);
+}
+
+void Ssd1683Sim::reset_registers_() {
+  for (auto &controller : this->controllers_) {
+    controller.entry_mode = 0x03;
+    controller.x_start = 0;
+    controller.x_end = RAM_WIDTH_BYTES - 1;
+    controller.y_start = 0;
+    controller.y_end = RAM_ROWS - 1;
+    controller.x_counter = 0;
+    controller.y_counter = 0;
+  }
+  this->update_sequence_ = 0xFF;
+}
+
+void Ssd1683Sim::error_(const char *format, ...) {
+  if (this->errors_.size() >= MAX_ERRORS)
+    return;
+  char buffer[160];
+  va_list arg;
+  va_start(arg, format);
+  vsnprintf(buffer, sizeof(buffer), format, arg);
+  va_end(arg);
+  const uint64_t now_us = host::Clock::now_ns() / 1000u;
+  this->errors_.push_back("t=" + std::to_string(now_us) + "us: " + buffer);
+}
+
+void Ssd1683Sim::receive(uint8_t byte, bool data) {
+  if (data) {
+    this->data_bytes_++;
+    this->refresh_data_bytes_++;
+  } else {
+    this->command_bytes_++;
+    this->refresh_command_bytes_++;
+  }
+  if (this->busy())
+    this->bytes_while_busy_++;
+  if (this->in_reset_) {
+    this->error_("0x%02X clocked in while the controller is held in reset", byte);
+    return;
+  }
+  if (this->asleep_) {
+    this->error_("0x%02X clocked in during deep sleep", byte);
+    return;
+  }
+  if (data) {
+    this->data_(byte);
+  } else {
+    this->begin_command_(byte);
+  }
+}
+
+void Ssd1683Sim::begin_command_(uint8_t byte) {
+  this->end_command_();
+  this->command_ = byte & ~TARGET_SECONDARY;
+  this->target_ = (byte & TARGET_SECONDARY) ? 1 : 0;
+  this->args_.clear();
+  this->ram_bytes_ = 0;
+  this->in_command_ = true;
+  if (this->target_ >= this->controller_count_)
+    this->error_("Command 0x%02X for the secondary controller of a single controller panel", this->command_);
+  if (parameter_count(this->command_) == -2)
+    this->error_("Unknown command 0x%02X", this->command_);
+
+  switch (this->command_) {
+    case CMD_SOFT_RESET:
+      // Restarts the whole cascade, the RAM is kept.
+      this->soft_resets_++;
+      this->reset_registers_();
+      this->start_busy_(this->busy_times_.soft_reset_us);
+      break;
+    case CMD_DISPLAY_UPDATE:
+      this->activate_();
+      break;
+    default:
+      break;
+  }
+}
+
+void Ssd1683Sim::end_command_() {
+  if (!this->in_command_)
+    return;
+  this->in_command_ = false;
+  const int expected = parameter_count(this->command_);
+  if (expected >= 0 && static_cast<int>(this->args_.size()) != expected) {
+    this->error_("Command 0x%02X got %zu parameters, expected %d", this->command_, this->args_.size(), expected);
+  }
+  this->commands_.push_back({host::Clock::now_ns(), this->command_, this->target_, this->args_, this->ram_bytes_});
+}
+
+void Ssd1683Sim::data_(uint8_t byte) {
+  if (!this->in_command_) {
+    this->error_("Data 0x%02X without a command", byte);
+    return;
+  }
+  Controller &controller = this->controllers_[this->target_ < this->controller_count_ ? this->target_ : 0];
+  if (this->command_ == CMD_WRITE_RAM || this->command_ == CMD_WRITE_OLD_RAM) {
+    this->write_ram_(controller, this->command_ == CMD_WRITE_RAM ? Ram::NEW_IMAGE : Ram::OLD_IMAGE, byte);
+    this->ram_bytes_++;
+    return;
+  }
+
+  this->args_.push_back(byte);
+  const std::vector<uint8_t> &a = this->args_;
+  const int expected = parameter_count(this->command_);
+  if (static_cast<int>(a.size()) != expected)
+    return;
+  // The register takes effect with its last parameter.
+  switch (this->command_) {
+    case CMD_DATA_ENTRY_MODE:
+      controller.entry_mode = a[0] & 0x07;
+      break;
+    case CMD_SET_X_ADDR:
+      controller.x_start = a[0] & 0x3F;
+      controller.x_end = a[1] & 0x3F;
+      break;
+    case CMD_SET_Y_ADDR:
+      controller.y_start = a[0] | (a[1] & 0x01) << 8;
+      controller.y_end = a[2] | (a[3] & 0x01) << 8;
+      break;
+    case CMD_SET_X_COUNTER:
+      controller.x_counter = a[0] & 0x3F;
+      break;
+    case CMD_SET_Y_COUNTER:
+      controller.y_counter = a[0] | (a[1] & 0x01) << 8;
+      break;
+    case CMD_UPDATE_SEQUENCE:
+      this->update_sequence_ = a[0];
+      break;
+    case CMD_DEEP_SLEEP:
+      if (a[0] != 0x00)
+        this->asleep_ = true;
+      break;
+    default:
+      break;
+  }
+}
+
+// Moves a counter one step through its window. Returns true when it wrapped around.
+static bool step_counter(uint16_t &counter, uint16_t start, uint16_t end, bool increment) {
+  if (counter == end) {
+    counter = start;
+    return true;
+  }
+  counter += increment ? 1 : -1;
+  return false;
+}
+
+static bool inside(uint16_t value, uint16_t start, uint16_t end) {
+  return start <= end ? value >= start && value <= end : value >= end && value <= start;
+}
+
+void Ssd1683Sim::write_ram_(Controller &controller, Ram ram, uint8_t byte) {
+  const uint16_t x = controller.x_counter;
+  const uint16_t y = controller.y_counter;
+  if (x >= RAM_WIDTH_BYTES || y >= RAM_ROWS) {
+    this->error_("RAM write at column %u, row %u is outside the memory", x, y);
+  } else {
+    if (!inside(x, controller.x_start, controller.x_end) || !inside(y, controller.y_start, controller.y_end))
+      this->error_("RAM write at column %u, row %u is outside the window", x, y);
+    controller.ram[static_cast<uint8_t>(ram)][y * RAM_WIDTH_BYTES + x] = byte;
+  }
+
+  // Data entry mode: bit 0 X increments, bit 1 Y increments, bit 2 Y is the fast axis.
+  const bool x_increment = controller.entry_mode & 0x01;
+  const bool y_increment = controller.entry_mode & 0x02;
+  if (controller.entry_mode & 0x04) {
+    if (step_counter(controller.y_counter, controller.y_start, controller.y_end, y_increment))
+      step_counter(controller.x_counter, controller.x_start, controller.x_end, x_increment);
+  } else {
+    if (step_counter(controller.x_counter, controller.x_start, controller.x_end, x_increment))
+      step_counter(controller.y_counter, controller.y_start, controller.y_end, y_increment);
+  }
+}
+
+void Ssd1683Sim::activate_() {
+  if (!(this->update_sequence_ & SEQUENCE_DISPLAY)) {
+    if (this->update_sequence_ & SEQUENCE_LOAD_LUT) {
+      this->lut_loads_++;
+      this->start_busy_(this->busy_times_.lut_load_us);
+    }
+    return;
+  }
+  switch (this->update_sequence_) {
+    case 0xFF:
+      this->start_busy_(this->busy_times_.partial_us);
+      break;
+    case 0xC7:
+      this->start_busy_(this->busy_times_.fast_us);
+      break;
+    default:
+      this->start_busy_(this->busy_times_.full_us);
+      break;
+  }
+  RefreshRecord refresh{host::Clock::now_ns(),
+                        this->update_sequence_,
+                        this->refresh_command_bytes_,
+                        this->refresh_data_bytes_,
+                        this->frame(Ram::NEW_IMAGE),
+                        this->frame(Ram::OLD_IMAGE)};
+  this->refresh_command_bytes_ = this->refresh_data_bytes_ = 0;
+  this->refreshes_.push_back(std::move(refresh));
+  if (!this->dump_dir_.empty())
+    this->dump_(this->refreshes_.back());
+}
+
+std::vector<uint8_t> Ssd1683Sim::frame(Ram ram) const {
+  const uint16_t stride = this->frame_stride();
+  std::vector<uint8_t> frame(static_cast<size_t>(stride) * this->rows_);
+  const std::vector<uint8_t> &primary = this->ram(0, ram);
+  for (uint16_t y = 0; y < this->rows_; y++) {
+    const uint8_t *src = primary.data() + y * RAM_WIDTH_BYTES;
+    uint8_t *dst = frame.data() + y * stride;
+    for (uint16_t x = 0; x < RAM_WIDTH_BYTES; x++)
+      dst[x] = src[x];
+    if (this->controller_count_ == 1)
+      continue;
+    // The secondary controller is written right to left: its RAM column 49 is the shared
+    // column, column 0 the rightmost one.
+    const uint8_t *secondary = this->ram(1, ram).data() + y * RAM_WIDTH_BYTES;
+    for (uint16_t x = RAM_WIDTH_BYTES; x < stride; x++)
+      dst[x] = secondary[stride - 1 - x];
+  }
+  return frame;
+}
+
+bool Ssd1683Sim::shared_column_consistent(Ram ram) const {
+  if (this->controller_count_ == 1)
+    return true;
+  const uint16_t shared = RAM_WIDTH_BYTES - 1;
+  for (uint16_t y = 0; y < this->rows_; y++) {
+    if (this->ram(0, ram)[y * RAM_WIDTH_BYTES + shared] != this->ram(1, ram)[y * RAM_WIDTH_BYTES + shared])
+      return false;
+  }
+  return true;
+}
+
+void Ssd1683Sim::set_dump_dir(const std::string &directory, const std::string &prefix) {
+  this->dump_dir_ = directory;
+  this->dump_prefix_ = prefix;
+}
+
+void Ssd1683Sim::dump_(const RefreshRecord &refresh) {
+  char name[32];
+  snprintf(name, sizeof(name), "_%03zu_", this->refreshes_.size());
+  const std::string base = this->dump_dir_ + "/" + this->dump_prefix_ + name;
+  if (!write_pbm(base + "new.pbm", refresh.new_image, this->frame_stride(), this->rows_) ||
+      !write_pbm(base + "old.pbm", refresh.old_image, this->frame_stride(), this->rows_))
+    this->error_("Could not write %s*.pbm", base.c_str());
+}
+
+const char *Ssd1683Sim::sequence_name(uint8_t sequence) {
+  switch (sequence) {
+    case 0xF7:
+      return "full";
+    case 0xFF:
+      return "partial";
+    case 0xC7:
+      return "fast";
+    default:
+      return "other";
+  }
+}
+
+bool write_pbm(const std::string &path, const std::vector<uint8_t> &frame, uint16_t stride, uint16_t rows) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == nullptr)
+    return false;
+  const uint16_t width = stride * 8u;
+  fprintf(file, "P4\n%u %u\n", width, rows);
+  std::vector<uint8_t> row(stride);
+  for (uint16_t y = 0; y < rows; y++) {
+    const uint8_t *src = frame.data() + y * stride;
+    // PBM: 1 is black, leftmost pixel in the MSB. The native X axis runs the other way.
+    for (uint16_t x = 0; x < width; x++) {
+      const uint16_t native_x = width - 1 - x;
+      const bool white = src[native_x >> 3] & (0x80 >> (native_x & 7));
+      if (x % 8 == 0)
+        row[x >> 3] = 0;
+      if (!white)
+        row[x >> 3] |= 0x80 >> (x & 7);
+    }
+    fwrite(row.data(), 1, stride, file);
+  }
+  return fclose(file) == 0;
+}
+
+}  // namespace sim
+}  // namespace esphome
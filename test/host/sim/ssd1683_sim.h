@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mock_pin.h"
+
+namespace esphome {
+namespace sim {
+
+// RAM of an SSD1683, selected by the write command: 0x24 (new image) or 0x26 (old image).
+enum class Ram : uint8_t {
+  NEW_IMAGE = 0,
+  OLD_IMAGE = 1,
+};
+
+enum class PanelModel : uint8_t {
+  // 400x300, one controller
+  P4P2IN,
+  // 792x272, two cascaded controllers: the primary drives the left 400 columns left to right,
+  // the secondary the right 400 columns right to left. They share the middle 8.
+  P5P79IN,
+};
+
+// A command and its parameters as decoded from the bus. RAM writes only keep their length.
+struct BusCommand {
+  uint64_t at_ns;
+  uint8_t command;  // Without the cascade target bit
+  uint8_t target;   // 0 for the primary controller, 1 for the secondary (CMD_TARGET_SECONDARY)
+  std::vector<uint8_t> data;
+  uint32_t ram_bytes;
+};
+
+// A display update, recorded on master activation (0x20) with a display sequence in 0x22.
+struct RefreshRecord {
+  uint64_t at_ns;
+  uint8_t sequence;  // The 0x22 parameter: 0xF7 full, 0xFF partial, 0xC7 fast
+  // Bus traffic since the previous refresh, this one's 0x20 included.
+  uint32_t command_bytes;
+  uint32_t data_bytes;
+  // Both RAMs at the time of the refresh, in the driver's native buffer layout.
+  std::vector<uint8_t> new_image;
+  std::vector<uint8_t> old_image;
+};
+
+// Model of the SSD1683 controller(s) of one panel, fed with bytes by an SpiWire.
+//
+// Commands, address windows, counters, data entry modes and cascade targets are decoded into a
+// virtual RAM per controller. Protocol violations (unknown commands, wrong parameter counts,
+// RAM writes outside the memory, traffic during deep sleep or reset) are collected in errors().
+class Ssd1683Sim {
+ public:
+  // RAM of one controller: 50 byte columns (400 sources) by 300 gate lines, of which a panel
+  // may use fewer.
+  static const uint8_t RAM_WIDTH_BYTES = 50;
+  static const uint16_t RAM_ROWS = 300;
+
+  // How long BUSY stays high, see attach_busy().
+  struct BusyTimes {
+    uint32_t soft_reset_us{2000};
+    uint32_t full_us{3000000};
+    uint32_t partial_us{600000};
+    uint32_t fast_us{1500000};
+    uint32_t lut_load_us{50000};
+  };
+
+  explicit Ssd1683Sim(PanelModel model);
+  ~Ssd1683Sim();
+
+  // Hardware reset: low holds the controller in reset, the rising edge restarts it.
+  void attach_reset(MockPin *reset);
+  // BUSY goes high on soft reset and master activation and falls on the virtual clock once the
+  // operation is done. A hardware reset drops it.
+  void attach_busy(MockPin *busy);
+  void set_busy_times(const BusyTimes &times) { this->busy_times_ = times; }
+  // BUSY stays high once raised, like a panel that never finishes its waveform.
+  void set_busy_stuck(bool stuck) { this->busy_stuck_ = stuck; }
+  bool busy() const { return this->busy_ != nullptr && this->busy_->level(); }
+  // Bytes clocked in while BUSY was high, which the controller may drop.
+  uint32_t bytes_while_busy() const { return this->bytes_while_busy_; }
+
+  // A byte clocked in while selected; `data` is the D/C level at its last bit.
+  void receive(uint8_t byte, bool data);
+
+  PanelModel model() const { return this->model_; }
+  uint8_t controller_count() const { return this->controller_count_; }
+  // Gate lines the panel shows.
+  uint16_t rows() const { return this->rows_; }
+  // Native frame width in bytes: 50 for the 4.2in panel, 99 for the 5.79in one.
+  uint16_t frame_stride() const;
+  uint16_t frame_width_px() const { return this->frame_stride() * 8u; }
+
+  // One controller's RAM, RAM_WIDTH_BYTES per row, RAM_ROWS rows.
+  const std::vector<uint8_t> &ram(uint8_t controller, Ram ram) const {
+    return this->controllers_[controller].ram[static_cast<uint8_t>(ram)];
+  }
+  // What the panel shows from a RAM, in the driver's (non-split) native buffer layout.
+  std::vector<uint8_t> frame(Ram ram) const;
+  // Whether both controllers hold the same data in the column they share.
+  bool shared_column_consistent(Ram ram) const;
+
+  const std::vector<BusCommand> &commands() const { return this->commands_; }
+  void clear_commands() { this->commands_.clear(); }
+  const std::vector<RefreshRecord> &refreshes() const { return this->refreshes_; }
+  const std::vector<std::string> &errors() const { return this->errors_; }
+  // Commands and data bytes received since the last reset_counters().
+  uint32_t command_bytes() const { return this->command_bytes_; }
+  uint32_t data_bytes() const { return this->data_bytes_; }
+  void reset_counters() { this->command_bytes_ = this->data_bytes_ = 0; }
+
+  bool asleep() const { return this->asleep_; }
+  uint32_t hardware_resets() const { return this->hardware_resets_; }
+  uint32_t soft_resets() const { return this->soft_resets_; }
+  uint32_t lut_loads() const { return this->lut_loads_; }
+
+  // Writes new_<n>.pbm and old_<n>.pbm (both RAMs) into `directory` on every refresh.
+  void set_dump_dir(const std::string &directory, const std::string &prefix);
+
+  // The 0x22 parameter in plain words.
+  static const char *sequence_name(uint8_t sequence);
+
+ protected:
+  struct Controller {
+    std::vector<uint8_t> ram[2];
+    uint8_t entry_mode;
+    uint16_t x_start, x_end, y_start, y_end;
+    uint16_t x_counter, y_counter;
+  };
+
+  void error_(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void reset_registers_();
+  void begin_command_(uint8_t byte);
+  void end_command_();
+  void data_(uint8_t byte);
+  void write_ram_(Controller &controller, Ram ram, uint8_t byte);
+  void activate_();
+  void start_busy_(uint32_t duration_us);
+  void end_busy_();
+  void dump_(const RefreshRecord &refresh);
+
+  PanelModel model_;
+  uint8_t controller_count_;
+  uint16_t rows_;
+  Controller controllers_[2];
+
+  bool in_command_{false};
+  uint8_t command_{0};
+  uint8_t target_{0};
+  std::vector<uint8_t> args_;
+  uint32_t ram_bytes_{0};
+
+  uint8_t update_sequence_{0xFF};
+  bool asleep_{false};
+  bool in_reset_{false};
+  uint32_t hardware_resets_{0};
+  uint32_t soft_resets_{0};
+  uint32_t lut_loads_{0};
+
+  MockPin *busy_{nullptr};
+  BusyTimes busy_times_{};
+  bool busy_stuck_{false};
+  uint32_t busy_alarm_{0};
+  uint32_t bytes_while_busy_{0};
+
+  uint32_t command_bytes_{0};
+  uint32_t data_bytes_{0};
+  uint32_t refresh_command_bytes_{0};
+  uint32_t refresh_data_bytes_{0};
+
+  std::vector<BusCommand> commands_;
+  std::vector<RefreshRecord> refreshes_;
+  std::vector<std::string> errors_;
+  std::string dump_dir_;
+  std::string dump_prefix_;
+};
+
+// Writes a 1bpp frame in the driver's native layout (0 bits are black, X mirrored) as a binary
+// PBM, the right way round for rotation 0.
+bool write_pbm(const std::string &path, const std::vector<uint8_t> &frame, uint16_t stride, uint16_t rows);
+
+}  // namespace sim
+}  // namespace esphome
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include "crowpanel_transport.h"
+#include "host/runtime.h"
+#include "spi_wire.h"
+
+namespace esphome {
+namespace sim {
+
+// Transport that hands bytes straight to an SpiWire instead of toggling pins, charging the
+// virtual clock `ns_per_byte` for each. Counts the calls the driver makes and can refuse setup().
+class WireTransport : public crowpanel_epaper::CrowPanelTransport {
+ public:
+  explicit WireTransport(SpiWire *wire, uint32_t ns_per_byte = 400) : wire_(wire), ns_per_byte_(ns_per_byte) {}
+
+  bool setup() override {
+    this->setup_calls++;
+    return !this->fail_setup;
+  }
+  void dump_config() override {}
+  void write_byte(uint8_t data) override {
+    this->byte_writes++;
+    host::Clock::advance_ns(this->ns_per_byte_);
+    this->wire_->clock_byte(data);
+  }
+  void write_array(const uint8_t *data, size_t len) override {
+    this->array_writes++;
+    for (size_t i = 0; i < len; i++) {
+      host::Clock::advance_ns(this->ns_per_byte_);
+      this->wire_->clock_byte(data[i]);
+    }
+  }
+  void flush() override { this->flushes++; }
+  // The wire gets slower or faster from here on.
+  void set_ns_per_byte(uint32_t ns_per_byte) { this->ns_per_byte_ = ns_per_byte; }
+
+  bool fail_setup{false};
+  uint32_t setup_calls{0};
+  uint32_t byte_writes{0};
+  uint32_t array_writes{0};
+  uint32_t flushes{0};
+
+ protected:
+  SpiWire *wire_;
+  uint32_t ns_per_byte_;
+};
+
+}  // namespace sim
+}  // namespace esphome
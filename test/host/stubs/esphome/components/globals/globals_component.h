@@ -0,0 +1,21 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace globals {
+
+template<typename T> class GlobalsComponent : public Component {
+ public:
+  using value_type = T;
+  explicit GlobalsComponent() = default;
+  explicit GlobalsComponent(T initial_value) : value_(initial_value) {}
+
+  T &value() { return this->value_; }
+
+ protected:
+  T value_{};
+};
+
+}  // namespace globals
+}  // namespace esphome
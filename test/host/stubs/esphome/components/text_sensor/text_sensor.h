@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace text_sensor {
+
+class TextSensor {
+ public:
+  void publish_state(const std::string &state) {
+    this->raw_state = state;
+    this->state = state;
+    this->has_state_ = true;
+    for (auto &callback : this->callbacks_)
+      callback(state);
+  }
+  void add_on_state_callback(std::function<void(std::string)> callback) {
+    this->callbacks_.push_back(std::move(callback));
+  }
+  bool has_state() const { return this->has_state_; }
+
+  std::string state;
+  std::string raw_state;
+
+ protected:
+  bool has_state_{false};
+  std::vector<std::function<void(std::string)>> callbacks_;
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ctime>
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/time.h"
+
+namespace esphome {
+namespace time {
+
+// Keeps UTC as local time. Invalid until set_epoch_time(), then it runs on the virtual clock.
+class RealTimeClock : public PollingComponent {
+ public:
+  void update() override {}
+
+  void set_epoch_time(time_t epoch) {
+    this->epoch_ = epoch;
+    this->set_at_ms_ = millis();
+  }
+  ESPTime now() { return ESPTime::from_epoch_utc(this->timestamp_now()); }
+  ESPTime utcnow() { return this->now(); }
+  time_t timestamp_now() {
+    if (this->epoch_ == 0)
+      return 0;
+    return this->epoch_ + (millis() - this->set_at_ms_) / 1000u;
+  }
+
+ protected:
+  time_t epoch_{0};
+  uint32_t set_at_ms_{0};
+};
+
+}  // namespace time
+}  // namespace esphome
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+  TemplatableValue(T value) : value_(value), has_value_(true) {}
+  template<typename F, typename = decltype(std::declval<F>()(std::declval<X>()...))>
+  TemplatableValue(F f) : f_(f), has_value_(true) {}
+
+  bool has_value() const { return this->has_value_; }
+  T value(X... x) { return this->f_ ? this->f_(x...) : this->value_; }
+
+ protected:
+  T value_{};
+  std::function<T(X...)> f_{};
+  bool has_value_{false};
+};
+
+#define TEMPLATABLE_VALUE_(type, name) \
+ protected: \
+  TemplatableValue<type, Ts...> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) { this->name##_ = name; }
+
+#define TEMPLATABLE_VALUE(type, name) TEMPLATABLE_VALUE_(type, name)
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+template<typename T> class Parented {
+ public:
+  Parented() {}
+  Parented(T *parent) : parent_(parent) {}
+  T *get_parent() const { return this->parent_; }
+  void set_parent(T *parent) { this->parent_ = parent; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+}  // namespace esphome
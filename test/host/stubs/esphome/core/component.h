@@ -0,0 +1,77 @@
+#pragma once
+
+// Host stand-in for esphome/core/component.h. Timeouts and intervals go to the host
+// scheduler, and loop() is called by host::Runner, see host_runtime.h.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/gpio.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float BUS;
+extern const float IO;
+extern const float HARDWARE;
+extern const float DATA;
+extern const float PROCESSOR;
+extern const float AFTER_WIFI;
+extern const float LATE;
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+  virtual void on_safe_shutdown() {}
+  virtual void call_setup() { this->setup(); }
+
+  void mark_failed();
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning(const char *message = nullptr) {}
+  void status_clear_warning() {}
+
+  void disable_loop();
+  void enable_loop();
+  // Safe from an ISR, the loop is enabled again before the next round.
+  void enable_loop_soon_any_context();
+  bool is_loop_enabled() const { return this->loop_enabled_; }
+  bool take_pending_enable_loop() {
+    const bool pending = this->pending_enable_loop_;
+    this->pending_enable_loop_ = false;
+    return pending;
+  }
+
+ protected:
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+  bool cancel_interval(const std::string &name);
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const std::string &name);
+
+  bool failed_{false};
+  bool loop_enabled_{true};
+  volatile bool pending_enable_loop_{false};
+};
+
+class PollingComponent : public Component {
+ public:
+  PollingComponent() : PollingComponent(0) {}
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual void update() = 0;
+  void call_setup() override;
+  uint32_t get_update_interval() const { return this->update_interval_; }
+
+ protected:
+  uint32_t update_interval_;
+};
+
+}  // namespace esphome
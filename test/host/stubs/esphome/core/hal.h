@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for esphome/core/hal.h. Time is virtual, see host_runtime.h.
+
+#include <cstddef>
+#include <cstdint>
+
+#define IRAM_ATTR
+#define HOT __attribute__((hot))
+#define ESPHOME_ALWAYS_INLINE __attribute__((always_inline))
+
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+}  // namespace esphome
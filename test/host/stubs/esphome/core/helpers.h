@@ -0,0 +1,86 @@
+#pragma once
+
+// Host stand-in for the parts of esphome/core/helpers.h the component uses.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+template<typename T> using optional = std::optional<T>;
+
+namespace host {
+// Makes the next `count` allocations that allow failure return nullptr, to exercise fallbacks.
+void fail_next_allocations(uint32_t count);
+bool take_allocation_failure();
+}  // namespace host
+
+template<class T> class RAMAllocator {
+ public:
+  using value_type = T;
+
+  enum Flags {
+    NONE = 0,
+    ALLOC_EXTERNAL = 1 << 0,
+    ALLOC_INTERNAL = 1 << 1,
+    ALLOW_FAILURE = 1 << 2,
+  };
+
+  RAMAllocator(uint8_t flags = ALLOC_INTERNAL | ALLOC_EXTERNAL) : flags_(flags) {}
+  template<class U> constexpr RAMAllocator(const RAMAllocator<U> &other) : flags_{other.flags_} {}
+
+  T *allocate(size_t n) {
+    if ((this->flags_ & ALLOW_FAILURE) && host::take_allocation_failure())
+      return nullptr;
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *p, size_t n) { ::operator delete(p); }
+
+  uint8_t flags_;
+};
+
+template<class T> bool operator==(const RAMAllocator<T> &, const RAMAllocator<T> &) { return true; }
+template<class T> bool operator!=(const RAMAllocator<T> &, const RAMAllocator<T> &) { return false; }
+
+template<class T> class ExternalRAMAllocator : public RAMAllocator<T> {
+ public:
+  enum Flags {
+    NONE = 0,
+    ALLOW_FAILURE = RAMAllocator<T>::ALLOW_FAILURE,
+  };
+
+  ExternalRAMAllocator(uint8_t flags = NONE) : RAMAllocator<T>(flags | RAMAllocator<T>::ALLOC_EXTERNAL) {}
+};
+
+// Loops back to back while any requester is active.
+class HighFrequencyLoopRequester {
+ public:
+  void start();
+  void stop();
+  static bool is_high_frequency();
+
+ protected:
+  bool started_{false};
+};
+
+class InterruptLock {
+ public:
+  InterruptLock() {}
+  ~InterruptLock() {}
+};
+
+uint32_t fnv1_hash(const std::string &str);
+
+template<typename T> constexpr const T &clamp(const T &v, const T &lo, const T &hi) {
+  return v < lo ? lo : (hi < v ? hi : v);
+}
+
+}  // namespace esphome
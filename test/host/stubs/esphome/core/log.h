@@ -0,0 +1,46 @@
+#pragma once
+
+// Host stand-in for esphome/core/log.h. Everything goes to stderr, filtered by
+// host::set_log_level() or the CROWPANEL_HOST_LOG environment variable (e, w, i, c, d, v).
+
+#include <cstdio>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+enum HostLogLevel : int {
+  ESPHOME_LOG_LEVEL_NONE = 0,
+  ESPHOME_LOG_LEVEL_ERROR = 1,
+  ESPHOME_LOG_LEVEL_WARN = 2,
+  ESPHOME_LOG_LEVEL_INFO = 3,
+  ESPHOME_LOG_LEVEL_CONFIG = 4,
+  ESPHOME_LOG_LEVEL_DEBUG = 5,
+  ESPHOME_LOG_LEVEL_VERBOSE = 6,
+  ESPHOME_LOG_LEVEL_VERY_VERBOSE = 7,
+};
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_ERROR, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_WARN, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_INFO, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) \
+  ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_CONFIG, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_DEBUG, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_VERBOSE, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) \
+  ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_VERY_VERBOSE, tag, __LINE__, __VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) \
+  if ((pin) != nullptr) { \
+    ESP_LOGCONFIG(TAG, prefix "%s", (pin)->dump_summary().c_str()); \
+  }
+#define LOG_UPDATE_INTERVAL(this) \
+  ESP_LOGCONFIG(TAG, "  Update Interval: %.1fs", (this)->get_update_interval() / 1000.0f)
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "esphome/core/macros.h"
+
+// The ESPHome release the host stubs follow.
+#define ESPHOME_VERSION "2025.9.0"
+#define ESPHOME_VERSION_CODE VERSION_CODE(2025, 9, 0)
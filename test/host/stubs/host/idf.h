@@ -0,0 +1,37 @@
+#pragma once
+
+// Control over the fake ESP-IDF SPI master and heap_caps_malloc().
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace host {
+namespace idf {
+
+enum class Call : uint8_t {
+  BUS_INITIALIZE,
+  ADD_DEVICE,
+  QUEUE_TRANS,
+  DMA_MALLOC,
+};
+
+// The next `count` calls of `call` fail.
+void fail_next(Call call, uint32_t count = 1);
+// Receives the bytes of each transaction once it has shifted out.
+void set_sink(std::function<void(const uint8_t *data, size_t len)> &&sink);
+
+bool bus_initialized(int host);
+uint32_t device_count();
+// Transactions started with spi_device_queue_trans() and spi_device_polling_transmit().
+uint32_t queued_transactions();
+uint32_t polled_transactions();
+// DMA buffers currently allocated.
+uint32_t dma_buffers();
+
+void reset();
+
+}  // namespace idf
+}  // namespace host
+}  // namespace esphome
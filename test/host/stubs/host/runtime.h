@@ -0,0 +1,85 @@
+#pragma once
+
+// The host side of the stubs: a virtual clock, the scheduler behind Component::set_timeout()
+// and set_interval(), and a runner that calls setup() and loop() like esphome::Application.
+//
+// Nothing here sleeps. Time only moves when something advances the clock: the runner between
+// loop() rounds, delay() and delayMicroseconds(), and simulated hardware that charges for the
+// bytes it receives. Alarms fire at their exact time while the clock passes them, which is how
+// simulated pins change state in the middle of a loop() call.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace host {
+
+class Clock {
+ public:
+  static uint64_t now_ns();
+  static void advance_ns(uint64_t ns);
+  static void advance_us(uint64_t us) { advance_ns(us * 1000u); }
+  static void advance_ms(uint64_t ms) { advance_ns(ms * 1000000u); }
+  // Runs `callback` when the clock reaches `at_ns`, or right away if that has already passed.
+  // Returns an id for cancel().
+  static uint32_t at(uint64_t at_ns, std::function<void()> &&callback);
+  static void cancel(uint32_t id);
+  // Back to zero, alarms dropped.
+  static void reset();
+};
+
+// Timeouts and intervals, run by Runner before each loop() round like the ESPHome scheduler.
+class Scheduler {
+ public:
+  static void set(Component *component, const std::string &name, uint32_t delay_ms, bool repeat,
+                  std::function<void()> &&callback);
+  static bool cancel(Component *component, const std::string &name, bool repeat);
+  // Runs everything that is due, in order of due time.
+  static void run_due();
+  static bool has(Component *component, const std::string &name);
+  static void reset();
+};
+
+class Runner {
+ public:
+  void add(Component *component) { this->components_.push_back({component, 0}); }
+  // Calls setup() on every component, highest setup priority first.
+  void setup();
+  // One Application::loop() round: the scheduler, then every component whose loop() is enabled.
+  // The clock then moves on by the loop interval, or by the loop overhead while a component asks
+  // for high frequency looping.
+  void loop_once();
+  void run_for_ms(uint32_t ms);
+  // Loops until `done` returns true or `max_ms` passed. Returns `done()`.
+  bool run_until(const std::function<bool()> &done, uint32_t max_ms);
+
+  uint32_t loop_calls(const Component *component) const;
+  void set_loop_interval_us(uint32_t us) { this->loop_interval_us_ = us; }
+  void set_loop_overhead_us(uint32_t us) { this->loop_overhead_us_ = us; }
+
+ protected:
+  struct Entry {
+    Component *component;
+    uint32_t loop_calls;
+  };
+  std::vector<Entry> components_;
+  uint32_t loop_interval_us_{16000};
+  uint32_t loop_overhead_us_{200};
+};
+
+// Fresh state for the next test: clock at zero, no timeouts, alarms or high frequency requests.
+void reset();
+
+// Log levels as in esphome/core/log.h. Also set by CROWPANEL_HOST_LOG=e|w|i|c|d|v.
+void set_log_level(int level);
+// Counts ESP_LOGE/ESP_LOGW calls since the last reset, so tests can assert on them.
+uint32_t error_count();
+uint32_t warning_count();
+void reset_log_counts();
+
+}  // namespace host
+}  // namespace esphome
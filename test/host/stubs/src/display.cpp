@@ -0,0 +1,303 @@
+#include "esphome/components/display/display_buffer.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include "esphome/core/application.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace display {
+
+static const char *const TAG = "display";
+
+const Color COLOR_OFF(0, 0, 0, 0);
+const Color COLOR_ON(255, 255, 255, 255);
+
+void Display::fill(Color color) { this->filled_rectangle(0, 0, this->get_width(), this->get_height(), color); }
+void Display::clear() { this->fill(COLOR_OFF); }
+
+void Display::line(int x1, int y1, int x2, int y2, Color color) {
+  const int32_t dx = abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+  const int32_t dy = -abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+  int32_t err = dx + dy;
+
+  while (true) {
+    this->draw_pixel_at(x1, y1, color);
+    if (x1 == x2 && y1 == y2)
+      break;
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+void Display::horizontal_line(int x, int y, int width, Color color) {
+  // Future: Could be made more efficient by manipulating buffer directly in certain rotations.
+  for (int i = x; i < x + width; i++)
+    this->draw_pixel_at(i, y, color);
+}
+
+void Display::vertical_line(int x, int y, int height, Color color) {
+  // Future: Could be made more efficient by manipulating buffer directly in certain rotations.
+  for (int i = y; i < y + height; i++)
+    this->draw_pixel_at(x, i, color);
+}
+
+void Display::rectangle(int x1, int y1, int width, int height, Color color) {
+  this->horizontal_line(x1, y1, width, color);
+  this->horizontal_line(x1, y1 + height - 1, width, color);
+  this->vertical_line(x1, y1, height, color);
+  this->vertical_line(x1 + width - 1, y1, height, color);
+}
+
+void Display::filled_rectangle(int x1, int y1, int width, int height, Color color) {
+  // Future: Use vertical_line and horizontal_line methods depending on rotation to reduce memory accesses.
+  for (int i = y1; i < y1 + height; i++) {
+    this->horizontal_line(x1, i, width, color);
+  }
+}
+
+void Display::print(int x, int y, BaseFont *font, Color color, TextAlign align, const char *text, Color background) {
+  int x_start, y_start;
+  int width, height;
+  this->get_text_bounds(x, y, text, font, align, &x_start, &y_start, &width, &height);
+  font->print(x_start, y_start, this, color, text, background);
+}
+
+void Display::print(int x, int y, BaseFont *font, Color color, const char *text, Color background) {
+  this->print(x, y, font, color, TextAlign::TOP_LEFT, text, background);
+}
+void Display::print(int x, int y, BaseFont *font, TextAlign align, const char *text) {
+  this->print(x, y, font, COLOR_ON, align, text);
+}
+void Display::print(int x, int y, BaseFont *font, const char *text) {
+  this->print(x, y, font, COLOR_ON, TextAlign::TOP_LEFT, text);
+}
+
+void Display::vprintf_(int x, int y, BaseFont *font, Color color, Color background, TextAlign align,
+                       const char *format, va_list arg) {
+  char buffer[256];
+  int ret = vsnprintf(buffer, sizeof(buffer), format, arg);
+  if (ret > 0)
+    this->print(x, y, font, color, align, buffer, background);
+}
+
+void Display::printf(int x, int y, BaseFont *font, Color color, Color background, TextAlign align,
+                     const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_(x, y, font, color, background, align, format, arg);
+  va_end(arg);
+}
+void Display::printf(int x, int y, BaseFont *font, Color color, TextAlign align, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_(x, y, font, color, COLOR_OFF, align, format, arg);
+  va_end(arg);
+}
+void Display::printf(int x, int y, BaseFont *font, Color color, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_(x, y, font, color, COLOR_OFF, TextAlign::TOP_LEFT, format, arg);
+  va_end(arg);
+}
+void Display::printf(int x, int y, BaseFont *font, TextAlign align, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_(x, y, font, COLOR_ON, COLOR_OFF, align, format, arg);
+  va_end(arg);
+}
+void Display::printf(int x, int y, BaseFont *font, const char *format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  this->vprintf_(x, y, font, COLOR_ON, COLOR_OFF, TextAlign::TOP_LEFT, format, arg);
+  va_end(arg);
+}
+
+void Display::strftime(int x, int y, BaseFont *font, Color color, TextAlign align, const char *format,
+                       ESPTime time) {
+  char buffer[64];
+  size_t ret = time.strftime(buffer, sizeof(buffer), format);
+  if (ret > 0)
+    this->print(x, y, font, color, align, buffer);
+}
+void Display::strftime(int x, int y, BaseFont *font, Color color, const char *format, ESPTime time) {
+  this->strftime(x, y, font, color, TextAlign::TOP_LEFT, format, time);
+}
+void Display::strftime(int x, int y, BaseFont *font, TextAlign align, const char *format, ESPTime time) {
+  this->strftime(x, y, font, COLOR_ON, align, format, time);
+}
+void Display::strftime(int x, int y, BaseFont *font, const char *format, ESPTime time) {
+  this->strftime(x, y, font, COLOR_ON, TextAlign::TOP_LEFT, format, time);
+}
+
+void Display::get_text_bounds(int x, int y, const char *text, BaseFont *font, TextAlign align, int *x1, int *y1,
+                              int *width, int *height) {
+  int x_offset, baseline;
+  font->measure(text, width, &x_offset, &baseline, height);
+
+  auto x_align = TextAlign(int(align) & 0x18);
+  auto y_align = TextAlign(int(align) & 0x07);
+
+  switch (x_align) {
+    case TextAlign::RIGHT:
+      *x1 = x - *width - x_offset;
+      break;
+    case TextAlign::CENTER_HORIZONTAL:
+      *x1 = x - (*width + x_offset) / 2;
+      break;
+    case TextAlign::LEFT:
+    default:
+      // LEFT
+      *x1 = x;
+      break;
+  }
+
+  switch (y_align) {
+    case TextAlign::BOTTOM:
+      *y1 = y - *height;
+      break;
+    case TextAlign::BASELINE:
+      *y1 = y - baseline;
+      break;
+    case TextAlign::CENTER_VERTICAL:
+      *y1 = y - (*height) / 2;
+      break;
+    case TextAlign::TOP:
+    default:
+      *y1 = y;
+      break;
+  }
+}
+
+void Display::show_page(DisplayPage *page) {
+  this->previous_page_ = this->page_;
+  this->page_ = page;
+}
+void Display::show_next_page() { this->page_->show_next(); }
+void Display::show_prev_page() { this->page_->show_prev(); }
+
+void Display::set_pages(std::vector<DisplayPage *> pages) {
+  for (auto *page : pages)
+    page->set_parent(this);
+
+  for (uint32_t i = 0; i < pages.size() - 1; i++) {
+    pages[i]->set_next(pages[i + 1]);
+    pages[i + 1]->set_prev(pages[i]);
+  }
+  pages[0]->set_prev(pages[pages.size() - 1]);
+  pages[pages.size() - 1]->set_next(pages[0]);
+  this->show_page(pages[0]);
+}
+
+void Display::do_update_() {
+  if (this->auto_clear_enabled_)
+    this->clear();
+  if (this->page_ != nullptr) {
+    this->page_->get_writer()(*this);
+  } else if (this->writer_.has_value()) {
+    (*this->writer_)(*this);
+  }
+  this->clear_clipping_();
+}
+
+void Display::start_clipping(Rect rect) {
+  if (!this->clipping_rectangle_.empty()) {
+    Rect r = this->clipping_rectangle_.back();
+    // Nested regions are intersected with the outer one.
+    const int16_t x = std::max(r.x, rect.x), y = std::max(r.y, rect.y);
+    const int16_t x2 = std::min(r.x2(), rect.x2()), y2 = std::min(r.y2(), rect.y2());
+    rect = Rect(x, y, std::max<int16_t>(0, x2 - x), std::max<int16_t>(0, y2 - y));
+  }
+  this->clipping_rectangle_.push_back(rect);
+}
+
+void Display::end_clipping() {
+  if (this->clipping_rectangle_.empty()) {
+    ESP_LOGE(TAG, "clear: Clipping is not set.");
+  } else {
+    this->clipping_rectangle_.pop_back();
+  }
+}
+
+Rect Display::get_clipping() const {
+  if (this->clipping_rectangle_.empty())
+    return Rect();
+  return this->clipping_rectangle_.back();
+}
+
+void DisplayPage::show() { this->parent_->show_page(this); }
+void DisplayPage::show_next() { this->next_->show(); }
+void DisplayPage::show_prev() { this->prev_->show(); }
+
+// ========================================================
+// DisplayBuffer
+// ========================================================
+
+void DisplayBuffer::init_internal_(uint32_t buffer_length) {
+  RAMAllocator<uint8_t> allocator;
+  this->buffer_ = allocator.allocate(buffer_length);
+  if (this->buffer_ == nullptr) {
+    ESP_LOGE(TAG, "Could not allocate buffer for display!");
+    return;
+  }
+  this->clear();
+}
+
+int DisplayBuffer::get_width() {
+  switch (this->rotation_) {
+    case DISPLAY_ROTATION_90_DEGREES:
+    case DISPLAY_ROTATION_270_DEGREES:
+      return this->get_height_internal();
+    case DISPLAY_ROTATION_0_DEGREES:
+    case DISPLAY_ROTATION_180_DEGREES:
+    default:
+      return this->get_width_internal();
+  }
+}
+
+int DisplayBuffer::get_height() {
+  switch (this->rotation_) {
+    case DISPLAY_ROTATION_0_DEGREES:
+    case DISPLAY_ROTATION_180_DEGREES:
+      return this->get_height_internal();
+    case DISPLAY_ROTATION_90_DEGREES:
+    case DISPLAY_ROTATION_270_DEGREES:
+    default:
+      return this->get_width_internal();
+  }
+}
+
+void HOT DisplayBuffer::draw_pixel_at(int x, int y, Color color) {
+  if (!this->get_clipping().inside(x, y))
+    return;  // NOLINT
+
+  switch (this->rotation_) {
+    case DISPLAY_ROTATION_0_DEGREES:
+      break;
+    case DISPLAY_ROTATION_90_DEGREES:
+      std::swap(x, y);
+      x = this->get_width_internal() - x - 1;
+      break;
+    case DISPLAY_ROTATION_180_DEGREES:
+      x = this->get_width_internal() - x - 1;
+      y = this->get_height_internal() - y - 1;
+      break;
+    case DISPLAY_ROTATION_270_DEGREES:
+      std::swap(x, y);
+      y = this->get_height_internal() - y - 1;
+      break;
+  }
+  this->draw_absolute_pixel_internal(x, y, color);
+  App.feed_wdt();
+}
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,211 @@
+#include "host/idf.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+#include <set>
+
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "host/runtime.h"
+
+struct spi_device_t {
+  spi_host_device_t host;
+  uint64_t ns_per_byte;
+  size_t queue_size;
+  struct Pending {
+    spi_transaction_t *transaction;
+    uint64_t done_ns;
+  };
+  // Queued transactions in order; the first is on the wire until its done_ns.
+  std::deque<Pending> pending;
+};
+
+namespace esphome {
+namespace host {
+namespace idf {
+
+namespace {
+
+// Time a transaction takes to set up before its first bit.
+const uint64_t QUEUED_SETUP_NS = 5000;
+const uint64_t POLLED_SETUP_NS = 2000;
+
+uint32_t failures[4]{};
+std::function<void(const uint8_t *, size_t)> sink;
+bool initialized[SPI_HOST_MAX]{};
+std::set<spi_device_t *> devices;
+std::set<void *> dma_allocations;
+uint32_t queued = 0;
+uint32_t polled = 0;
+// When the bus is free for the next transaction.
+uint64_t wire_free_ns = 0;
+
+bool take_failure(Call call) {
+  uint32_t &count = failures[static_cast<uint8_t>(call)];
+  if (count == 0)
+    return false;
+  count--;
+  return true;
+}
+
+void deliver(const spi_transaction_t *transaction) {
+  const size_t len = transaction->length / 8;
+  const uint8_t *data = (transaction->flags & SPI_TRANS_USE_TXDATA) ? transaction->tx_data
+                                                                     : static_cast<const uint8_t *>(transaction->tx_buffer);
+  if (sink)
+    sink(data, len);
+}
+
+}  // namespace
+
+void fail_next(Call call, uint32_t count) { failures[static_cast<uint8_t>(call)] = count; }
+void set_sink(std::function<void(const uint8_t *, size_t)> &&callback) { sink = std::move(callback); }
+bool bus_initialized(int host) { return host >= 0 && host < SPI_HOST_MAX && initialized[host]; }
+uint32_t device_count() { return devices.size(); }
+uint32_t queued_transactions() { return queued; }
+uint32_t polled_transactions() { return polled; }
+uint32_t dma_buffers() { return dma_allocations.size(); }
+
+void reset() {
+  for (auto &count : failures)
+    count = 0;
+  sink = nullptr;
+  for (auto &host : initialized)
+    host = false;
+  for (auto *device : devices)
+    delete device;
+  devices.clear();
+  for (auto *buffer : dma_allocations)
+    free(buffer);
+  dma_allocations.clear();
+  queued = polled = 0;
+  wire_free_ns = 0;
+}
+
+}  // namespace idf
+}  // namespace host
+}  // namespace esphome
+
+using esphome::host::Clock;
+using esphome::host::idf::Call;
+namespace idf = esphome::host::idf;
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  if ((caps & MALLOC_CAP_DMA) && idf::take_failure(Call::DMA_MALLOC))
+    return nullptr;
+  void *buffer = malloc(size);
+  if (caps & MALLOC_CAP_DMA)
+    idf::dma_allocations.insert(buffer);
+  return buffer;
+}
+
+void heap_caps_free(void *ptr) {
+  idf::dma_allocations.erase(ptr);
+  free(ptr);
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, spi_dma_chan_t dma_chan) {
+  if (host == SPI1_HOST || host >= SPI_HOST_MAX || bus_config == nullptr)
+    return ESP_ERR_INVALID_ARG;
+  if (idf::take_failure(Call::BUS_INITIALIZE))
+    return ESP_ERR_NO_MEM;
+  if (idf::initialized[host])
+    return ESP_ERR_INVALID_STATE;
+  idf::initialized[host] = true;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+  if (host >= SPI_HOST_MAX || !idf::initialized[host])
+    return ESP_ERR_INVALID_STATE;
+  for (auto *device : idf::devices) {
+    if (device->host == host)
+      return ESP_ERR_INVALID_STATE;
+  }
+  idf::initialized[host] = false;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle) {
+  if (host >= SPI_HOST_MAX || !idf::initialized[host])
+    return ESP_ERR_INVALID_STATE;
+  if (dev_config->clock_speed_hz <= 0 || dev_config->queue_size <= 0)
+    return ESP_ERR_INVALID_ARG;
+  if (idf::take_failure(Call::ADD_DEVICE))
+    return ESP_ERR_NOT_FOUND;
+  auto *device = new spi_device_t{host, 8000000000ull / dev_config->clock_speed_hz,
+                                  static_cast<size_t>(dev_config->queue_size), {}};
+  idf::devices.insert(device);
+  *handle = device;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+  if (idf::devices.erase(handle) == 0 || !handle->pending.empty())
+    return ESP_ERR_INVALID_STATE;
+  delete handle;
+  return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait) {
+  if (handle->pending.size() >= handle->queue_size)
+    return ESP_ERR_TIMEOUT;
+  if (idf::take_failure(Call::QUEUE_TRANS))
+    return ESP_ERR_NO_MEM;
+  const uint64_t start = std::max(Clock::now_ns() + idf::QUEUED_SETUP_NS, idf::wire_free_ns);
+  const uint64_t done = start + handle->ns_per_byte * (trans_desc->length / 8);
+  idf::wire_free_ns = done;
+  handle->pending.push_back({trans_desc, done});
+  idf::queued++;
+  // The data reaches the panel when the last bit is out, read from the buffer at that time.
+  Clock::at(done, [trans_desc]() { idf::deliver(trans_desc); });
+  return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+                                      TickType_t ticks_to_wait) {
+  if (handle->pending.empty())
+    return ESP_ERR_TIMEOUT;
+  const auto front = handle->pending.front();
+  if (Clock::now_ns() < front.done_ns)
+    Clock::advance_ns(front.done_ns - Clock::now_ns());
+  handle->pending.pop_front();
+  *trans_desc = front.transaction;
+  return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc) {
+  // Not allowed while queued transactions are outstanding.
+  if (!handle->pending.empty())
+    return ESP_ERR_INVALID_STATE;
+  const uint64_t start = std::max(Clock::now_ns(), idf::wire_free_ns);
+  const uint64_t done = start + idf::POLLED_SETUP_NS + handle->ns_per_byte * (trans_desc->length / 8);
+  Clock::advance_ns(done - Clock::now_ns());
+  idf::wire_free_ns = done;
+  idf::polled++;
+  idf::deliver(trans_desc);
+  return ESP_OK;
+}
@@ -0,0 +1,425 @@
+#include "host/runtime.h"
+#include "host/idf.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/time.h"
+
+namespace esphome {
+
+// ========================================================
+// Virtual clock
+// ========================================================
+
+namespace host {
+
+namespace {
+
+struct Alarm {
+  uint64_t at_ns;
+  uint32_t id;
+  std::function<void()> callback;
+};
+
+uint64_t clock_ns = 0;
+uint32_t next_alarm_id = 1;
+std::vector<Alarm> alarms;
+bool firing = false;
+
+}  // namespace
+
+uint64_t Clock::now_ns() { return clock_ns; }
+
+void Clock::advance_ns(uint64_t ns) {
+  const uint64_t target = clock_ns + ns;
+  // An alarm callback that takes time itself just moves the clock, without firing alarms.
+  if (firing) {
+    clock_ns = target;
+    return;
+  }
+  while (true) {
+    auto next = std::min_element(alarms.begin(), alarms.end(),
+                                 [](const Alarm &a, const Alarm &b) { return a.at_ns < b.at_ns; });
+    if (next == alarms.end() || next->at_ns > target)
+      break;
+    clock_ns = std::max(clock_ns, next->at_ns);
+    Alarm alarm = std::move(*next);
+    alarms.erase(next);
+    firing = true;
+    alarm.callback();
+    firing = false;
+  }
+  clock_ns = std::max(clock_ns, target);
+}
+
+uint32_t Clock::at(uint64_t at_ns, std::function<void()> &&callback) {
+  const uint32_t id = next_alarm_id++;
+  if (at_ns <= clock_ns && !firing) {
+    callback();
+    return id;
+  }
+  alarms.push_back({at_ns, id, std::move(callback)});
+  return id;
+}
+
+void Clock::cancel(uint32_t id) {
+  alarms.erase(std::remove_if(alarms.begin(), alarms.end(), [id](const Alarm &a) { return a.id == id; }),
+               alarms.end());
+}
+
+void Clock::reset() {
+  clock_ns = 0;
+  alarms.clear();
+}
+
+// ========================================================
+// Scheduler
+// ========================================================
+
+namespace {
+
+struct Item {
+  Component *component;
+  std::string name;
+  uint32_t interval;
+  uint64_t next_ms;
+  bool repeat;
+  bool removed;
+  uint64_t order;
+  std::function<void()> callback;
+};
+
+std::vector<Item> items;
+uint64_t item_order = 0;
+
+}  // namespace
+
+void Scheduler::set(Component *component, const std::string &name, uint32_t delay_ms, bool repeat,
+                    std::function<void()> &&callback) {
+  Scheduler::cancel(component, name, repeat);
+  if (delay_ms == UINT32_MAX)
+    return;  // SCHEDULER_DONT_RUN
+  items.push_back({component, name, delay_ms, millis() + static_cast<uint64_t>(delay_ms), repeat, false,
+                   item_order++, std::move(callback)});
+}
+
+bool Scheduler::cancel(Component *component, const std::string &name, bool repeat) {
+  bool found = false;
+  for (auto &item : items) {
+    if (!item.removed && item.component == component && item.name == name && item.repeat == repeat) {
+      item.removed = true;
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool Scheduler::has(Component *component, const std::string &name) {
+  return std::any_of(items.begin(), items.end(), [&](const Item &item) {
+    return !item.removed && item.component == component && item.name == name;
+  });
+}
+
+void Scheduler::run_due() {
+  const uint64_t now = Clock::now_ns() / 1000000u;
+  while (true) {
+    Item *next = nullptr;
+    for (auto &item : items) {
+      if (item.removed || item.next_ms > now)
+        continue;
+      if (next == nullptr || item.next_ms < next->next_ms ||
+          (item.next_ms == next->next_ms && item.order < next->order))
+        next = &item;
+    }
+    if (next == nullptr)
+      break;
+    // Copied out, the callback may add or cancel items.
+    Item item = *next;
+    if (item.repeat) {
+      next->next_ms = std::max(next->next_ms + next->interval, now + 1);
+    } else {
+      next->removed = true;
+    }
+    if (item.component == nullptr || !item.component->is_failed())
+      item.callback();
+  }
+  items.erase(std::remove_if(items.begin(), items.end(), [](const Item &item) { return item.removed; }), items.end());
+}
+
+void Scheduler::reset() { items.clear(); }
+
+// ========================================================
+// Runner
+// ========================================================
+
+void Runner::setup() {
+  std::stable_sort(this->components_.begin(), this->components_.end(), [](const Entry &a, const Entry &b) {
+    return a.component->get_setup_priority() > b.component->get_setup_priority();
+  });
+  for (auto &entry : this->components_) {
+    entry.component->call_setup();
+    if (!entry.component->is_failed())
+      entry.component->dump_config();
+  }
+}
+
+void Runner::loop_once() {
+  Scheduler::run_due();
+  for (auto &entry : this->components_) {
+    Component *component = entry.component;
+    if (component->is_failed())
+      continue;
+    if (component->take_pending_enable_loop())
+      component->enable_loop();
+    if (!component->is_loop_enabled())
+      continue;
+    component->loop();
+    entry.loop_calls++;
+  }
+  Clock::advance_us(HighFrequencyLoopRequester::is_high_frequency() ? this->loop_overhead_us_
+                                                                     : this->loop_interval_us_);
+}
+
+void Runner::run_for_ms(uint32_t ms) {
+  const uint64_t end = Clock::now_ns() + static_cast<uint64_t>(ms) * 1000000u;
+  while (Clock::now_ns() < end)
+    this->loop_once();
+}
+
+bool Runner::run_until(const std::function<bool()> &done, uint32_t max_ms) {
+  const uint64_t end = Clock::now_ns() + static_cast<uint64_t>(max_ms) * 1000000u;
+  while (!done()) {
+    if (Clock::now_ns() >= end)
+      return done();
+    this->loop_once();
+  }
+  return true;
+}
+
+uint32_t Runner::loop_calls(const Component *component) const {
+  for (const auto &entry : this->components_) {
+    if (entry.component == component)
+      return entry.loop_calls;
+  }
+  return 0;
+}
+
+// ========================================================
+// Logging
+// ========================================================
+
+namespace {
+
+int parse_log_level() {
+  const char *env = getenv("CROWPANEL_HOST_LOG");
+  if (env == nullptr)
+    return ESPHOME_LOG_LEVEL_WARN;
+  switch (env[0]) {
+    case 'n':
+      return ESPHOME_LOG_LEVEL_NONE;
+    case 'e':
+      return ESPHOME_LOG_LEVEL_ERROR;
+    case 'i':
+      return ESPHOME_LOG_LEVEL_INFO;
+    case 'c':
+      return ESPHOME_LOG_LEVEL_CONFIG;
+    case 'd':
+      return ESPHOME_LOG_LEVEL_DEBUG;
+    case 'v':
+      return ESPHOME_LOG_LEVEL_VERBOSE;
+    default:
+      return ESPHOME_LOG_LEVEL_WARN;
+  }
+}
+
+int log_level = parse_log_level();
+uint32_t errors = 0;
+uint32_t warnings = 0;
+
+}  // namespace
+
+void set_log_level(int level) { log_level = level; }
+uint32_t error_count() { return errors; }
+uint32_t warning_count() { return warnings; }
+void reset_log_counts() { errors = warnings = 0; }
+
+}  // namespace host
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  if (level == ESPHOME_LOG_LEVEL_ERROR)
+    host::errors++;
+  if (level == ESPHOME_LOG_LEVEL_WARN)
+    host::warnings++;
+  if (level > host::log_level)
+    return;
+  static const char LETTERS[] = "?EWICDVV";
+  const uint64_t now_us = host::Clock::now_ns() / 1000u;
+  fprintf(stderr, "[%7llu.%03llu][%c][%s:%03d]: ", static_cast<unsigned long long>(now_us / 1000u),
+          static_cast<unsigned long long>(now_us % 1000u), LETTERS[level], tag, line);
+  va_list arg;
+  va_start(arg, format);
+  vfprintf(stderr, format, arg);
+  va_end(arg);
+  fputc('\n', stderr);
+}
+
+// ========================================================
+// hal.h
+// ========================================================
+
+uint32_t millis() { return static_cast<uint32_t>(host::Clock::now_ns() / 1000000u); }
+uint32_t micros() { return static_cast<uint32_t>(host::Clock::now_ns() / 1000u); }
+void delay(uint32_t ms) { host::Clock::advance_ms(ms); }
+void delayMicroseconds(uint32_t us) { host::Clock::advance_us(us); }
+
+// ========================================================
+// helpers.h
+// ========================================================
+
+namespace host {
+namespace {
+uint32_t failing_allocations = 0;
+}  // namespace
+void fail_next_allocations(uint32_t count) { failing_allocations = count; }
+bool take_allocation_failure() {
+  if (failing_allocations == 0)
+    return false;
+  failing_allocations--;
+  return true;
+}
+}  // namespace host
+
+namespace host {
+namespace {
+uint32_t high_frequency_requests = 0;
+}  // namespace
+}  // namespace host
+
+void HighFrequencyLoopRequester::start() {
+  if (this->started_)
+    return;
+  host::high_frequency_requests++;
+  this->started_ = true;
+}
+
+void HighFrequencyLoopRequester::stop() {
+  if (!this->started_)
+    return;
+  host::high_frequency_requests--;
+  this->started_ = false;
+}
+
+bool HighFrequencyLoopRequester::is_high_frequency() { return host::high_frequency_requests > 0; }
+
+void host::reset() {
+  Clock::reset();
+  Scheduler::reset();
+  high_frequency_requests = 0;
+  failing_allocations = 0;
+  idf::reset();
+  reset_log_counts();
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+// ========================================================
+// component.h
+// ========================================================
+
+namespace setup_priority {
+const float BUS = 1000.0f;
+const float IO = 900.0f;
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float PROCESSOR = 400.0f;
+const float AFTER_WIFI = 200.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+static const char *const TAG = "component";
+
+void Component::mark_failed() {
+  ESP_LOGE(TAG, "Component was marked as failed");
+  this->failed_ = true;
+}
+
+void Component::disable_loop() { this->loop_enabled_ = false; }
+void Component::enable_loop() { this->loop_enabled_ = true; }
+void Component::enable_loop_soon_any_context() { this->pending_enable_loop_ = true; }
+
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  host::Scheduler::set(this, name, interval, true, std::move(f));
+}
+bool Component::cancel_interval(const std::string &name) { return host::Scheduler::cancel(this, name, true); }
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  host::Scheduler::set(this, name, timeout, false, std::move(f));
+}
+bool Component::cancel_timeout(const std::string &name) { return host::Scheduler::cancel(this, name, false); }
+
+void PollingComponent::call_setup() {
+  this->setup();
+  if (!this->is_failed())
+    this->set_interval("update", this->get_update_interval(), [this]() { this->update(); });
+}
+
+Application App;  // NOLINT
+
+// ========================================================
+// gpio.h
+// ========================================================
+
+bool ISRInternalGPIOPin::digital_read() { return false; }
+void ISRInternalGPIOPin::digital_write(bool value) {}
+
+// ========================================================
+// time.h
+// ========================================================
+
+size_t ESPTime::strftime(char *buffer, size_t buffer_len, const char *format) {
+  struct tm c_tm = {};
+  c_tm.tm_sec = this->second;
+  c_tm.tm_min = this->minute;
+  c_tm.tm_hour = this->hour;
+  c_tm.tm_mday = this->day_of_month;
+  c_tm.tm_mon = this->month - 1;
+  c_tm.tm_year = this->year - 1900;
+  c_tm.tm_wday = this->day_of_week - 1;
+  c_tm.tm_yday = this->day_of_year - 1;
+  c_tm.tm_isdst = this->is_dst;
+  return ::strftime(buffer, buffer_len, format, &c_tm);
+}
+
+ESPTime ESPTime::from_epoch_utc(time_t epoch) {
+  struct tm c_tm;
+  gmtime_r(&epoch, &c_tm);
+  ESPTime time{};
+  time.second = c_tm.tm_sec;
+  time.minute = c_tm.tm_min;
+  time.hour = c_tm.tm_hour;
+  time.day_of_week = c_tm.tm_wday + 1;
+  time.day_of_month = c_tm.tm_mday;
+  time.day_of_year = c_tm.tm_yday + 1;
+  time.month = c_tm.tm_mon + 1;
+  time.year = c_tm.tm_year + 1900;
+  time.is_dst = c_tm.tm_isdst;
+  time.timestamp = epoch;
+  return time;
+}
+
+}  // namespace esphome
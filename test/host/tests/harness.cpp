@@ -0,0 +1,56 @@
+#include "harness.h"
+
+#include <cstring>
+#include <vector>
+
+#include "host/runtime.h"
+
+namespace harness {
+
+namespace {
+
+struct Case {
+  const char *name;
+  void (*body)();
+};
+
+std::vector<Case> &cases() {
+  static std::vector<Case> all;
+  return all;
+}
+
+uint32_t failures = 0;
+
+}  // namespace
+
+void register_case(const char *name, void (*body)()) { cases().push_back({name, body}); }
+
+void fail(const char *file, int line, const std::string &message) {
+  failures++;
+  fprintf(stderr, "%s:%d: FAILED %s\n", file, line, message.c_str());
+}
+
+}  // namespace harness
+
+// Runs every case, or those whose name contains argv[1].
+int main(int argc, char **argv) {
+  uint32_t failed_cases = 0;
+  uint32_t run = 0;
+  for (const auto &test : harness::cases()) {
+    if (argc > 1 && strstr(test.name, argv[1]) == nullptr)
+      continue;
+    esphome::host::reset();
+    const uint32_t before = harness::failures;
+    try {
+      test.body();
+    } catch (const harness::Failure &) {
+    }
+    run++;
+    const bool ok = harness::failures == before;
+    if (!ok)
+      failed_cases++;
+    printf("[%s] %s\n", ok ? " OK " : "FAIL", test.name);
+  }
+  printf("%u of %u cases passed\n", run - failed_cases, run);
+  return failed_cases == 0 && run > 0 ? 0 : 1;
+}
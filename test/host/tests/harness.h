@@ -0,0 +1,55 @@
+#pragma once
+
+// Minimal test runner: TEST_CASE registers a function, CHECK records a failure and carries on,
+// REQUIRE stops the case. Every case starts from host::reset().
+
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace harness {
+
+struct Failure {};
+
+void register_case(const char *name, void (*body)());
+void fail(const char *file, int line, const std::string &message);
+
+template<typename A, typename B> std::string describe(const char *expr, const A &a, const B &b) {
+  std::ostringstream out;
+  out << expr << " (" << +a << " vs " << +b << ")";
+  return out.str();
+}
+
+struct Registration {
+  Registration(const char *name, void (*body)()) { register_case(name, body); }
+};
+
+}  // namespace harness
+
+#define TEST_CASE(name) \
+  static void name(); \
+  static const harness::Registration name##_registration(#name, name); \
+  static void name()
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) \
+      harness::fail(__FILE__, __LINE__, #cond); \
+  } while (false)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    const auto &check_a_ = (a); \
+    const auto &check_b_ = (b); \
+    if (!(check_a_ == check_b_)) \
+      harness::fail(__FILE__, __LINE__, harness::describe(#a " == " #b, check_a_, check_b_)); \
+  } while (false)
+
+#define REQUIRE(cond) \
+  do { \
+    if (!(cond)) { \
+      harness::fail(__FILE__, __LINE__, #cond); \
+      throw harness::Failure(); \
+    } \
+  } while (false)
@@ -0,0 +1,90 @@
+// The retained background layer: drawn once, copied under every frame, and drawn again when
+// something it depends on changes.
+
+#include <vector>
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+namespace {
+
+struct Layers {
+  int step{0};
+  int frame_x{0};
+  uint32_t background_draws{0};
+  void background(CrowPanelEPaper &it) const {
+    it.rectangle(this->frame_x, 0, it.get_width() - this->frame_x, it.get_height());
+    it.line(0, 40, it.get_width() - 1, 40);
+  }
+  void foreground(CrowPanelEPaper &it) const { it.filled_rectangle(30 + 6 * this->step, 80, 40, 40); }
+};
+
+void set_background(Rig4P2In &rig, Layers &layers) {
+  rig.panel.set_background_writer([&layers](CrowPanelEPaper &it) {
+    layers.background_draws++;
+    layers.background(it);
+  });
+}
+
+void start(Rig4P2In &rig, Layers &layers) {
+  set_background(rig, layers);
+  rig.panel.set_panel_writer([&layers](CrowPanelEPaper &it) { layers.foreground(it); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+}
+
+// Both layers drawn straight into the panel's buffer, once the panel is idle.
+std::vector<uint8_t> expected_frame(Rig4P2In &rig, const Layers &layers) {
+  rig.panel.fill(display::COLOR_OFF);
+  layers.background(rig.panel);
+  layers.foreground(rig.panel);
+  return std::vector<uint8_t>(rig.panel.buffer(), rig.panel.buffer() + rig.panel.buffer_length());
+}
+
+}  // namespace
+
+TEST_CASE(background_drawn_once) {
+  Rig4P2In rig;
+  Layers layers;
+  start(rig, layers);
+  CHECK(rig.panel.background_valid());
+  for (layers.step = 1; layers.step < 4; layers.step++)
+    REQUIRE(rig.update());
+  layers.step--;
+  CHECK_EQ(layers.background_draws, 1u);
+  CHECK_EQ(rig.sim.refreshes().size(), 4u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, layers));
+}
+
+TEST_CASE(rotation_redraws_background) {
+  Rig4P2In rig;
+  Layers layers;
+  start(rig, layers);
+  rig.panel.set_rotation(display::DISPLAY_ROTATION_180_DEGREES);
+  CHECK(!rig.panel.background_valid());
+  layers.step = 1;
+  REQUIRE(rig.update());
+  CHECK_EQ(layers.background_draws, 2u);
+  CHECK(rig.panel.background_valid());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, layers));
+}
+
+TEST_CASE(new_background_writer_redraws_background) {
+  Rig4P2In rig;
+  Layers layers;
+  start(rig, layers);
+
+  Layers moved;
+  moved.frame_x = 25;
+  set_background(rig, moved);
+  CHECK(!rig.panel.background_valid());
+  REQUIRE(rig.update());
+  CHECK_EQ(layers.background_draws, 1u);
+  CHECK_EQ(moved.background_draws, 1u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, moved));
+  CHECK(rig.sim.errors().empty());
+}
@@ -0,0 +1,52 @@
+// run_benchmark() must leave the panel exactly as it found it.
+
+#include <vector>
+
+#include "font_loader.h"
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+TEST_CASE(run_benchmark_has_no_side_effects) {
+  Rig4P2In rig;
+  rig.panel.set_page_cache(true);
+  rig.panel.set_rotation(display::DISPLAY_ROTATION_90_DEGREES);
+  rig.panel.set_background_writer([](CrowPanelEPaper &it) { it.rectangle(0, 0, it.get_width(), 30); });
+  display::DisplayPage first([](display::Display &it) { it.filled_rectangle(10, 40, 50, 50); });
+  display::DisplayPage second([](display::Display &it) { it.filled_rectangle(100, 40, 50, 50); });
+  rig.panel.set_pages({&first, &second});
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  rig.panel.show_page(&second);
+  REQUIRE(rig.update());
+  REQUIRE(rig.panel.background_valid());
+  REQUIRE(rig.panel.page_cached(&first));
+  REQUIRE(rig.panel.page_cached(&second));
+
+  const std::vector<uint8_t> frame(rig.panel.buffer(), rig.panel.buffer() + rig.panel.buffer_length());
+  const auto *page = rig.panel.last_drawn_page();
+  const uint32_t generation = rig.panel.drawn_generation();
+  const int width = rig.panel.get_width();
+  const size_t refreshes = rig.sim.refreshes().size();
+
+  auto font = load_font(font_path("OpenSans-Medium.ttf"), 20, ascii_chars());
+  rig.panel.run_benchmark(font != nullptr ? font->get() : nullptr);
+
+  CHECK(std::vector<uint8_t>(rig.panel.buffer(), rig.panel.buffer() + rig.panel.buffer_length()) == frame);
+  CHECK_EQ(rig.panel.rotation(), display::DISPLAY_ROTATION_90_DEGREES);
+  CHECK_EQ(rig.panel.get_width(), width);
+  CHECK(rig.panel.background_valid());
+  CHECK(rig.panel.page_cached(&first));
+  CHECK(rig.panel.page_cached(&second));
+  CHECK(rig.panel.last_drawn_page() == page);
+  CHECK_EQ(rig.panel.drawn_generation(), generation);
+
+  // The switch back is still served from the cache and matches what was shown before.
+  rig.panel.show_page(&first);
+  REQUIRE(rig.update());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.sim.refreshes()[refreshes - 2].new_image);
+  CHECK(rig.sim.errors().empty());
+}
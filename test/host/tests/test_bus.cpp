@@ -0,0 +1,113 @@
+// Two panels on one CLK/MOSI pair through a CrowPanelBus, each with its own CS, D/C, reset and
+// BUSY lines and its own simulated controller.
+
+#include "crowpanel_bus.h"
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using crowpanel_epaper::EpdState;
+
+namespace {
+
+// The rig's panel and wire, plus a second panel next to it on the same bus.
+struct TwoPanels {
+  TwoPanels() {
+    this->rig.wire.add_panel(&this->sim, &this->cs, &this->dc);
+    this->sim.attach_reset(&this->reset);
+    this->sim.attach_busy(&this->busy);
+    this->panel.set_cs_pin(&this->cs);
+    this->panel.set_dc_pin(&this->dc);
+    this->panel.set_reset_pin(&this->reset);
+    this->panel.set_busy_pin(&this->busy);
+    this->panel.set_update_interval(UINT32_MAX);
+    this->rig.panel.set_bus(&this->bus);
+    this->panel.set_bus(&this->bus);
+    this->rig.runner.add(&this->bus);
+    this->rig.runner.add(&this->panel);
+  }
+
+  bool idle() { return this->rig.panel.is_idle() && this->panel.is_idle(); }
+  bool start() {
+    this->rig.runner.setup();
+    return this->rig.runner.run_until([this]() { return this->idle(); }, 5000);
+  }
+  bool update() {
+    this->rig.panel.update();
+    this->panel.update();
+    return this->rig.runner.run_until([this]() { return this->idle(); }, 120000);
+  }
+
+  Rig4P2In rig;
+  MockPin cs{39, "cs2", true};
+  MockPin dc{40, "dc2", true};
+  MockPin reset{41, "reset2", true};
+  MockPin busy{42, "busy2"};
+  Ssd1683Sim sim{PanelModel::P4P2IN};
+  TestPanel<crowpanel_epaper::CrowPanelEPaper4P2In> panel;
+  crowpanel_epaper::CrowPanelBus bus{&rig.transport};
+};
+
+void check_clean(const TwoPanels &panels) {
+  for (const auto *sim : {&panels.rig.sim, &panels.sim}) {
+    for (const auto &error : sim->errors())
+      harness::fail(__FILE__, __LINE__, "sim: " + error);
+    CHECK_EQ(sim->bytes_while_busy(), 0u);
+  }
+  for (const auto &error : panels.rig.wire.errors())
+    harness::fail(__FILE__, __LINE__, "wire: " + error);
+}
+
+void set_writers(TwoPanels &panels, int &step) {
+  panels.rig.panel.set_panel_writer([&step](CrowPanelEPaper &it) { it.filled_rectangle(20 + 5 * step, 20, 200, 100); });
+  panels.panel.set_panel_writer([&step](CrowPanelEPaper &it) {
+    it.rectangle(10, 10, 300, 200);
+    it.filled_rectangle(100, 150 + 3 * step, 120, 60);
+  });
+}
+
+}  // namespace
+
+TEST_CASE(two_panels_share_one_bus) {
+  TwoPanels panels;
+  int step = 0;
+  set_writers(panels, step);
+  REQUIRE(panels.start());
+  for (; step < 3; step++) {
+    REQUIRE(panels.update());
+    CHECK(panels.rig.sim.frame(Ram::NEW_IMAGE) == panels.rig.panel.transfer_frame());
+    CHECK(panels.sim.frame(Ram::NEW_IMAGE) == panels.panel.transfer_frame());
+  }
+  CHECK_EQ(panels.rig.sim.refreshes().size(), 3u);
+  CHECK_EQ(panels.sim.refreshes().size(), 3u);
+  CHECK(panels.rig.sim.frame(Ram::NEW_IMAGE) != panels.sim.frame(Ram::NEW_IMAGE));
+  check_clean(panels);
+}
+
+TEST_CASE(shut_down_panel_releases_bus) {
+  // Wherever the first panel is in the slice queue when it shuts down, the second one finishes.
+  for (int rounds = 0; rounds < 4; rounds++) {
+    TwoPanels panels;
+    int step = 0;
+    set_writers(panels, step);
+    REQUIRE(panels.start());
+    panels.rig.panel.update();
+    panels.panel.update();
+    REQUIRE(panels.rig.runner.run_until(
+        [&panels]() {
+          return panels.rig.panel.state() == EpdState::UPDATE_SENDING_DATA &&
+                 panels.panel.state() == EpdState::UPDATE_SENDING_DATA;
+        },
+        5000));
+    for (int i = 0; i < rounds; i++)
+      panels.rig.runner.loop_once();
+
+    // Stops looping like a component after shutdown.
+    panels.rig.panel.on_safe_shutdown();
+    panels.rig.panel.mark_failed();
+    REQUIRE(panels.rig.runner.run_until([&panels]() { return panels.panel.is_idle(); }, 60000));
+    CHECK(panels.sim.frame(Ram::NEW_IMAGE) == panels.panel.transfer_frame());
+  }
+}
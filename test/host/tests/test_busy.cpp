@@ -0,0 +1,156 @@
+// BUSY handling: the loop sleeps through the refresh, the falling edge wakes it, and the busy
+// timeout catches an edge that never comes.
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using crowpanel_epaper::EpdState;
+
+namespace {
+
+const uint64_t NS_PER_MS = 1000000u;
+
+int frame_number = 0;
+
+// Different content on every frame, so no update is skipped as unchanged.
+void draw(CrowPanelEPaper &it) { it.filled_rectangle(30 + frame_number++, 30, 100, 100); }
+
+// Starts an update and runs until the panel has begun refreshing.
+template<typename R> bool start_refresh(R &rig) {
+  const size_t refreshes = rig.sim.refreshes().size();
+  rig.panel.update();
+  return rig.runner.run_until(
+      [&]() { return rig.sim.refreshes().size() > refreshes && rig.panel.state() == EpdState::UPDATE_WAIT_REFRESH; },
+      10000);
+}
+
+template<typename R> bool wait_refresh_done(R &rig, uint32_t max_ms) {
+  return rig.runner.run_until([&]() { return rig.panel.state() != EpdState::UPDATE_WAIT_REFRESH; }, max_ms);
+}
+
+// BUSY read through a pin without interrupts, like one on an I/O expander.
+class ExpanderPin : public GPIOPin {
+ public:
+  explicit ExpanderPin(GPIOPin *pin) : pin_(pin) {}
+  void setup() override {}
+  void pin_mode(gpio::Flags flags) override {}
+  bool digital_read() override { return this->pin_->digital_read(); }
+  void digital_write(bool value) override {}
+  std::string dump_summary() const override { return "expander"; }
+
+ protected:
+  GPIOPin *pin_;
+};
+
+}  // namespace
+
+TEST_CASE(loop_sleeps_until_busy_falls) {
+  Rig4P2In rig;
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  REQUIRE(start_refresh(rig));
+  const uint64_t refresh_at = rig.sim.refreshes().back().at_ns;
+  const uint32_t calls = rig.runner.loop_calls(&rig.panel);
+
+  REQUIRE(wait_refresh_done(rig, 10000));
+  // Woken by the edge, not polled through the 3s refresh.
+  CHECK(rig.runner.loop_calls(&rig.panel) - calls <= 3);
+  const uint64_t woke_ms = (host::Clock::now_ns() - refresh_at) / NS_PER_MS;
+  CHECK(woke_ms >= 3000 && woke_ms <= 3020);
+  // Measured from the loop() round that starts the refresh sequence.
+  CHECK(rig.panel.refresh_duration_us() >= 3000000 && rig.panel.refresh_duration_us() <= 3017000);
+  CHECK(!host::Scheduler::has(&rig.panel, "busy_timeout"));
+  REQUIRE(rig.wait_idle());
+  CHECK_EQ(rig.sim.bytes_while_busy(), 0u);
+  CHECK_EQ(host::warning_count(), 0u);
+}
+
+TEST_CASE(update_during_refresh_keeps_edge) {
+  Rig4P2In rig;
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  REQUIRE(start_refresh(rig));
+  const uint64_t refresh_at = rig.sim.refreshes().back().at_ns;
+
+  rig.runner.run_for_ms(1000);
+  rig.panel.update();
+  REQUIRE(wait_refresh_done(rig, 10000));
+  const uint64_t woke_ms = (host::Clock::now_ns() - refresh_at) / NS_PER_MS;
+  CHECK(woke_ms >= 3000 && woke_ms <= 3020);
+
+  // The queued update follows.
+  REQUIRE(rig.wait_idle());
+  CHECK_EQ(rig.sim.refreshes().size(), 2u);
+  CHECK_EQ(rig.sim.bytes_while_busy(), 0u);
+  CHECK_EQ(host::warning_count(), 0u);
+}
+
+TEST_CASE(stuck_busy_times_out_once) {
+  Rig4P2In rig;
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  rig.sim.set_busy_stuck(true);
+  REQUIRE(start_refresh(rig));
+  const uint64_t refresh_at = rig.sim.refreshes().back().at_ns;
+  const uint32_t calls = rig.runner.loop_calls(&rig.panel);
+
+  REQUIRE(!wait_refresh_done(rig, 59000));
+  CHECK(rig.runner.loop_calls(&rig.panel) - calls <= 2);
+  // Wakes loop() early, which must not push the timeout back by another minute.
+  rig.panel.update();
+  REQUIRE(wait_refresh_done(rig, 5000));
+  const uint64_t woke_ms = (host::Clock::now_ns() - refresh_at) / NS_PER_MS;
+  CHECK(woke_ms >= 60000 && woke_ms <= 60050);
+  CHECK(rig.runner.loop_calls(&rig.panel) - calls <= 6);
+  CHECK_EQ(host::warning_count(), 1u);
+}
+
+TEST_CASE(stuck_busy_without_updates) {
+  Rig5P79In rig;
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  rig.sim.set_busy_stuck(true);
+  REQUIRE(start_refresh(rig));
+  const uint64_t refresh_at = rig.sim.refreshes().back().at_ns;
+
+  REQUIRE(wait_refresh_done(rig, 70000));
+  const uint64_t woke_ms = (host::Clock::now_ns() - refresh_at) / NS_PER_MS;
+  CHECK(woke_ms >= 60000 && woke_ms <= 60050);
+  CHECK_EQ(host::warning_count(), 1u);
+}
+
+TEST_CASE(soft_reset_waits_for_busy) {
+  Rig4P2In rig;
+  Ssd1683Sim::BusyTimes times;
+  times.soft_reset_us = 40000;
+  rig.sim.set_busy_times(times);
+  REQUIRE(rig.start());
+  CHECK_EQ(rig.sim.soft_resets(), 1u);
+  // Nothing was sent while the controller was resetting.
+  CHECK_EQ(rig.sim.bytes_while_busy(), 0u);
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(busy_without_interrupt_is_polled) {
+  Rig4P2In rig;
+  ExpanderPin busy(&rig.busy);
+  rig.panel.set_busy_pin(&busy);
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  REQUIRE(start_refresh(rig));
+  const uint64_t refresh_at = rig.sim.refreshes().back().at_ns;
+  const uint32_t calls = rig.runner.loop_calls(&rig.panel);
+
+  REQUIRE(wait_refresh_done(rig, 10000));
+  // No edge to wake it, loop() keeps running and reads the pin.
+  CHECK(rig.runner.loop_calls(&rig.panel) - calls > 100);
+  const uint64_t woke_ms = (host::Clock::now_ns() - refresh_at) / NS_PER_MS;
+  CHECK(woke_ms >= 3000 && woke_ms <= 3040);
+  REQUIRE(rig.wait_idle());
+  CHECK_EQ(rig.sim.bytes_while_busy(), 0u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK_EQ(host::warning_count(), 0u);
+}
@@ -0,0 +1,146 @@
+// When automatic mode picks a full update: churn from partial updates, regional cleaning and quiet
+// hours.
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+namespace {
+
+const uint8_t FULL = 0xF7;
+const uint8_t PARTIAL = 0xFF;
+
+// A small moving mark, plus an optional block that flips most of the top left churn region.
+struct Scene {
+  int step{0};
+  bool block{false};
+  void draw(CrowPanelEPaper &it) const {
+    it.filled_rectangle(300 + 4 * this->step, 250, 8, 8);
+    if (this->block)
+      it.filled_rectangle(0, 0, 90, 70);
+  }
+};
+
+// Moves the mark and updates; returns the refresh sequence.
+uint8_t next_update(Rig4P2In &rig, Scene &scene) {
+  scene.step++;
+  REQUIRE(rig.update());
+  return rig.sim.refreshes().back().sequence;
+}
+
+// 2026-01-01 00:00 UTC.
+const time_t NEW_YEAR = 1767225600;
+time_t at_time(int day, int hour, int minute) { return NEW_YEAR + ((day * 24 + hour) * 60 + minute) * 60; }
+
+}  // namespace
+
+TEST_CASE(churn_threshold_triggers_full_update) {
+  Rig4P2In rig;
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  rig.panel.set_full_update_churn(0.5f);
+  // Ignored with a churn threshold.
+  rig.panel.set_full_update_every(2);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK_EQ(rig.sim.refreshes().back().sequence, FULL);
+
+  for (int i = 0; i < 4; i++)
+    CHECK_EQ(next_update(rig, scene), PARTIAL);
+
+  // The block goes out as a partial update, the one after it cleans up.
+  scene.block = true;
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK_EQ(next_update(rig, scene), FULL);
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(regional_clean_inverts_old_image) {
+  Rig4P2In rig;
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  rig.panel.set_full_update_churn(0.5f);
+  rig.panel.set_regional_full_update(true);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  scene.block = true;
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  const auto &window = rig.panel.clean_window();
+  // Only the top left of the 4x4 churn grid: 100x75 pixels.
+  // The 4.2in panel's native buffer runs mirrored, so these are its last columns.
+  CHECK_EQ(window.x_end, 49u);
+  CHECK_EQ(window.width_bytes(), 13u);
+  CHECK_EQ(window.y_start, 0u);
+  CHECK_EQ(window.height(), 300u / 4u);
+
+  // The old-image RAM holds the inverse of the new image there, so every pixel is driven.
+  const auto &refresh = rig.sim.refreshes().back();
+  const uint16_t stride = 50;
+  uint32_t inverted = 0;
+  for (uint16_t y = window.y_start; y <= window.y_end; y++) {
+    for (uint16_t x = window.x_start; x <= window.x_end; x++)
+      inverted += refresh.old_image[y * stride + x] == static_cast<uint8_t>(~refresh.new_image[y * stride + x]);
+  }
+  CHECK_EQ(inverted, window.size());
+  // Outside it only the moved mark differs.
+  CHECK(refresh.old_image[200 * stride + 2] == refresh.new_image[200 * stride + 2]);
+
+  // Synced again afterwards, and the cleaned region no longer counts.
+  CHECK(rig.sim.frame(Ram::OLD_IMAGE) == rig.sim.frame(Ram::NEW_IMAGE));
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(quiet_hours_postpone_full_update) {
+  Rig4P2In rig;
+  time::RealTimeClock clock;
+  clock.set_epoch_time(at_time(0, 23, 0));
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  rig.panel.set_full_update_every(4);
+  // 22:00 to 06:00, across midnight.
+  rig.panel.set_quiet_hours(&clock, 22 * 60, 6 * 60);
+  REQUIRE(rig.start());
+  // The first full update happens regardless, the panel shows nothing useful before.
+  REQUIRE(rig.update());
+  CHECK_EQ(rig.sim.refreshes().back().sequence, FULL);
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  // Due by count, postponed.
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+
+  clock.set_epoch_time(at_time(1, 5, 30));
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+
+  // Due since update 4, it runs with the first update after the window.
+  clock.set_epoch_time(at_time(1, 6, 0));
+  CHECK_EQ(next_update(rig, scene), FULL);
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(quiet_hours_within_one_day) {
+  Rig4P2In rig;
+  time::RealTimeClock clock;
+  clock.set_epoch_time(at_time(0, 12, 0));
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  rig.panel.set_full_update_every(2);
+  rig.panel.set_quiet_hours(&clock, 13 * 60, 14 * 60);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK_EQ(next_update(rig, scene), FULL);
+
+  clock.set_epoch_time(at_time(0, 13, 30));
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  CHECK_EQ(next_update(rig, scene), PARTIAL);
+  clock.set_epoch_time(at_time(0, 14, 0));
+  CHECK_EQ(next_update(rig, scene), FULL);
+}
@@ -0,0 +1,192 @@
+// Pages built the way display.py builds them draw through the CrowPanelEPaper primitives, and the
+// page cache serves them again until something invalidates it.
+
+#include "automation.h"
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+namespace {
+
+void draw(CrowPanelEPaper &it) {
+  it.filled_rectangle(20, 20, 200, 100);
+  it.rectangle(10, 150, 120, 60);
+  it.line(0, 250, it.get_width() - 1, 250);
+}
+
+// Two cached pages that count how often their writers run.
+struct CachedPages {
+  explicit CachedPages(Rig4P2In &rig)
+      : a(rig.panel.page_writer([this](CrowPanelEPaper &it) {
+          this->a_draws++;
+          it.filled_rectangle(20, 20, 200, 100);
+        })),
+        b(rig.panel.page_writer([this](CrowPanelEPaper &it) {
+          this->b_draws++;
+          draw(it);
+        })) {
+    rig.panel.set_pages({&this->a, &this->b});
+    rig.panel.set_page_cache(true);
+  }
+
+  uint32_t a_draws{0};
+  uint32_t b_draws{0};
+  display::DisplayPage a;
+  display::DisplayPage b;
+};
+
+// Shows A, then B, so both are cached.
+bool show_both(Rig4P2In &rig, CachedPages &pages) {
+  if (!rig.start() || !rig.update())
+    return false;
+  rig.panel.show_page(&pages.b);
+  return rig.update();
+}
+
+}  // namespace
+
+TEST_CASE(page_writer_uses_byte_primitives) {
+  Rig4P2In rig;
+  display::DisplayPage page(rig.panel.page_writer(draw));
+  rig.panel.set_pages({&page});
+  REQUIRE(rig.start());
+  rig.panel.pixel_calls = 0;
+  REQUIRE(rig.update());
+  CHECK_EQ(rig.panel.pixel_calls, 0u);
+  CHECK(rig.panel.last_drawn_page() == &page);
+
+  // Same frame as the per-pixel primitives of display::Display draw.
+  const std::vector<uint8_t> fast = rig.panel.transfer_frame();
+  rig.panel.fill(display::COLOR_OFF);
+  display::Display &base = rig.panel;
+  base.filled_rectangle(20, 20, 200, 100);
+  base.rectangle(10, 150, 120, 60);
+  base.line(0, 250, rig.panel.get_width() - 1, 250);
+  CHECK(rig.panel.pixel_calls > 0u);
+  CHECK(std::vector<uint8_t>(rig.panel.buffer(), rig.panel.buffer() + rig.panel.buffer_length()) == fast);
+}
+
+TEST_CASE(display_page_gets_plain_display) {
+  // A page built from a display::Display lambda, as display.register_display() builds it, draws
+  // pixel by pixel. This is what page_writer() avoids.
+  Rig4P2In rig;
+  display::DisplayPage page([](display::Display &it) { it.filled_rectangle(20, 20, 200, 100); });
+  rig.panel.set_pages({&page});
+  REQUIRE(rig.start());
+  rig.panel.pixel_calls = 0;
+  REQUIRE(rig.update());
+  CHECK(rig.panel.pixel_calls > 0u);
+}
+
+TEST_CASE(watched_change_reaches_cached_page) {
+  sensor::Sensor level;
+  level.publish_state(5);
+  auto draw_level = [&level](CrowPanelEPaper &it) { it.filled_rectangle(20, 20, 10 * level.state, 40); };
+  Rig4P2In rig;
+  display::DisplayPage a(rig.panel.page_writer(draw_level));
+  display::DisplayPage b(rig.panel.page_writer(draw));
+  rig.panel.set_pages({&a, &b});
+  rig.panel.set_page_cache(true);
+  rig.panel.add_watched_sensor(&level);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK(rig.panel.page_cached(&a));
+
+  rig.panel.show_page(&b);
+  REQUIRE(rig.update());
+  // Redraws page B and drops the frame cached for A along with it.
+  level.publish_state(12);
+  REQUIRE(rig.wait_idle());
+  CHECK(!rig.panel.page_cached(&a));
+
+  rig.panel.show_page(&a);
+  REQUIRE(rig.update());
+  CHECK(rig.panel.last_drawn_page() == &a);
+
+  Rig4P2In fresh;
+  display::DisplayPage expected(fresh.panel.page_writer(draw_level));
+  fresh.panel.set_pages({&expected});
+  REQUIRE(fresh.start());
+  REQUIRE(fresh.update());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == fresh.sim.frame(Ram::NEW_IMAGE));
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(page_cache_hit_skips_writer) {
+  Rig4P2In rig;
+  CachedPages pages(rig);
+  REQUIRE(show_both(rig, pages));
+  const std::vector<uint8_t> frame_a = rig.sim.refreshes().front().new_image;
+  CHECK(rig.panel.page_cached(&pages.a));
+  CHECK(rig.panel.page_cached(&pages.b));
+
+  rig.panel.show_page(&pages.a);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 1u);
+  CHECK(rig.panel.last_drawn_page() == &pages.a);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == frame_a);
+
+  // Staying on the page runs its writer, only a switch is served from the cache.
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 2u);
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(invalidated_page_renders_again) {
+  Rig4P2In rig;
+  CachedPages pages(rig);
+  REQUIRE(show_both(rig, pages));
+
+  rig.panel.invalidate_page_cache(&pages.a);
+  CHECK(!rig.panel.page_cached(&pages.a));
+  CHECK(rig.panel.page_cached(&pages.b));
+  rig.panel.show_page(&pages.a);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 2u);
+  CHECK(rig.panel.page_cached(&pages.a));
+
+  // The same through the automation action, once for one page and once for all of them.
+  crowpanel_epaper::InvalidatePageCacheAction<> action;
+  action.set_parent(&rig.panel);
+  action.play();
+  CHECK(!rig.panel.page_cached(&pages.a));
+  CHECK(!rig.panel.page_cached(&pages.b));
+  rig.panel.show_page(&pages.b);
+  REQUIRE(rig.update());
+  rig.panel.show_page(&pages.a);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 3u);
+  CHECK_EQ(pages.b_draws, 2u);
+
+  crowpanel_epaper::InvalidatePageCacheAction<> page_action;
+  page_action.set_parent(&rig.panel);
+  page_action.set_page(&pages.b);
+  page_action.play();
+  CHECK(!rig.panel.page_cached(&pages.b));
+  CHECK(rig.panel.page_cached(&pages.a));
+  rig.panel.show_page(&pages.b);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.b_draws, 3u);
+  rig.panel.show_page(&pages.a);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 3u);
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(rotation_drops_page_cache) {
+  Rig4P2In rig;
+  CachedPages pages(rig);
+  REQUIRE(show_both(rig, pages));
+
+  rig.panel.set_rotation(display::DISPLAY_ROTATION_90_DEGREES);
+  CHECK(!rig.panel.page_cached(&pages.a));
+  CHECK(!rig.panel.page_cached(&pages.b));
+  rig.panel.show_page(&pages.a);
+  REQUIRE(rig.update());
+  CHECK_EQ(pages.a_draws, 2u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(rig.sim.errors().empty());
+}
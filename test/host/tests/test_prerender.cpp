@@ -0,0 +1,110 @@
+// With a double buffer the next frame is rendered while the panel still shows the previous one.
+// Whatever is rendered ahead, the controller RAM ends up with the latest frame asked for.
+
+#include <vector>
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using crowpanel_epaper::EpdState;
+
+namespace {
+
+struct Scene {
+  int step{0};
+  uint32_t draws{0};
+  void draw(CrowPanelEPaper &it) const {
+    it.rectangle(0, 0, it.get_width(), it.get_height());
+    it.filled_rectangle(40 + 9 * this->step, 60, 30, 30);
+  }
+};
+
+void start(Rig4P2In &rig, Scene &scene) {
+  rig.panel.set_double_buffer(true);
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) {
+    scene.draws++;
+    scene.draw(it);
+  });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+}
+
+// Starts an update and runs the loop until the panel is busy with the refresh waveform.
+void start_refresh(Rig4P2In &rig) {
+  rig.panel.update();
+  REQUIRE(rig.runner.run_until([&rig]() { return rig.panel.state() == EpdState::UPDATE_WAIT_REFRESH; }, 60000));
+}
+
+// The frame `scene` draws, drawn into the panel's own buffer once the panel is idle.
+std::vector<uint8_t> expected_frame(Rig4P2In &rig, const Scene &scene) {
+  rig.panel.fill(display::COLOR_OFF);
+  scene.draw(rig.panel);
+  return std::vector<uint8_t>(rig.panel.buffer(), rig.panel.buffer() + rig.panel.buffer_length());
+}
+
+}  // namespace
+
+TEST_CASE(prerendered_frame_reaches_ram) {
+  Rig4P2In rig;
+  Scene scene;
+  start(rig, scene);
+  scene.step = 1;
+  start_refresh(rig);
+
+  scene.step = 2;
+  rig.panel.update();
+  REQUIRE(rig.runner.run_until([&rig]() { return rig.panel.frame_ready(); }, 1000));
+  CHECK(rig.panel.state() == EpdState::UPDATE_WAIT_REFRESH);
+  const uint32_t draws = scene.draws;
+  REQUIRE(rig.wait_idle());
+
+  // Not drawn again when its update started.
+  CHECK_EQ(scene.draws, draws);
+  REQUIRE(rig.sim.refreshes().size() == 3u);
+  CHECK(rig.sim.refreshes().back().new_image == rig.panel.transfer_frame());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, scene));
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(request_after_prerender_renders_again) {
+  Rig4P2In rig;
+  Scene scene;
+  start(rig, scene);
+  scene.step = 1;
+  start_refresh(rig);
+  rig.panel.update();
+  REQUIRE(rig.runner.run_until([&rig]() { return rig.panel.frame_ready(); }, 1000));
+
+  // What the ready frame shows is out of date now.
+  scene.step = 2;
+  rig.panel.update();
+  CHECK(!rig.panel.frame_ready());
+  const uint32_t draws = scene.draws;
+  REQUIRE(rig.wait_idle());
+  CHECK_EQ(scene.draws, draws + 1u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, scene));
+  CHECK(rig.sim.errors().empty());
+}
+
+TEST_CASE(last_of_quick_updates_wins) {
+  Rig4P2In rig;
+  Scene scene;
+  start(rig, scene);
+  scene.step = 1;
+  start_refresh(rig);
+
+  // Some land between loop() calls, some while a frame is ready or being uploaded.
+  for (scene.step = 2; scene.step < 8; scene.step++) {
+    rig.panel.update();
+    for (int i = 0; i < scene.step % 3; i++)
+      rig.runner.loop_once();
+  }
+  scene.step--;
+  REQUIRE(rig.wait_idle());
+  CHECK(rig.sim.refreshes().back().new_image == rig.panel.transfer_frame());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == expected_frame(rig, scene));
+  CHECK(rig.sim.errors().empty());
+}
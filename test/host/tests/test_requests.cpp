@@ -0,0 +1,200 @@
+// Update requests: on a frame the panel already shows, held back by the rate limits, and merged
+// while one is pending.
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using crowpanel_epaper::UpdateMode;
+using crowpanel_epaper::UpdatePriority;
+
+namespace {
+
+void draw(CrowPanelEPaper &it) { it.filled_rectangle(20, 20, 200, 100); }
+
+// Starts the rig and shows the first frame.
+template<typename R> void show_first_frame(R &rig) {
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  REQUIRE(rig.sim.refreshes().size() == 1u);
+}
+
+template<typename R> bool request(R &rig, UpdateMode mode) {
+  rig.panel.request_update(UpdatePriority::ROUTINE, mode);
+  return rig.wait_idle();
+}
+
+const uint32_t MINUTE_MS = 60000;
+
+uint64_t now_ms() { return host::Clock::now_ns() / 1000000u; }
+uint64_t refresh_ms(const Rig4P2In &rig, size_t index) { return rig.sim.refreshes()[index].at_ns / 1000000u; }
+
+// A frame that changes with every request, so none of them is skipped as unchanged.
+struct Counter {
+  int value{0};
+  void draw(CrowPanelEPaper &it) const { it.filled_rectangle(20 + 4 * this->value, 20, 8, 8); }
+};
+
+void start(Rig4P2In &rig, Counter &counter) {
+  rig.panel.set_panel_writer([&counter](CrowPanelEPaper &it) { counter.draw(it); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  REQUIRE(rig.sim.refreshes().size() == 1u);
+}
+
+void change(Rig4P2In &rig, Counter &counter, UpdatePriority priority = UpdatePriority::ROUTINE) {
+  counter.value++;
+  rig.panel.request_update(priority);
+}
+
+}  // namespace
+
+TEST_CASE(unchanged_frame_is_skipped) {
+  Rig4P2In rig;
+  show_first_frame(rig);
+  REQUIRE(rig.update());
+  CHECK_EQ(rig.sim.refreshes().size(), 1u);
+  CHECK_EQ(rig.panel.get_skipped_update_count(), 1u);
+}
+
+TEST_CASE(unchanged_frame_partial_request_is_skipped) {
+  Rig4P2In rig;
+  show_first_frame(rig);
+  REQUIRE(request(rig, UpdateMode::PARTIAL));
+  CHECK_EQ(rig.sim.refreshes().size(), 1u);
+  CHECK_EQ(rig.panel.get_skipped_update_count(), 1u);
+}
+
+TEST_CASE(unchanged_frame_full_request_refreshes) {
+  Rig4P2In rig;
+  show_first_frame(rig);
+  REQUIRE(request(rig, UpdateMode::FULL));
+  REQUIRE(rig.sim.refreshes().size() == 2u);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xF7);
+  CHECK(rig.panel.update_mode() == UpdateMode::FULL);
+  CHECK_EQ(rig.panel.get_skipped_update_count(), 0u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+}
+
+TEST_CASE(unchanged_frame_fast_request_refreshes) {
+  Rig4P2In rig;
+  show_first_frame(rig);
+  REQUIRE(request(rig, UpdateMode::FAST));
+  REQUIRE(rig.sim.refreshes().size() == 2u);
+  CHECK(rig.panel.update_mode() != UpdateMode::PARTIAL);
+  CHECK_EQ(rig.panel.get_skipped_update_count(), 0u);
+}
+
+TEST_CASE(min_update_interval_defers_routine_update) {
+  Rig4P2In rig;
+  Counter counter;
+  rig.panel.set_min_update_interval(MINUTE_MS);
+  start(rig, counter);
+
+  change(rig, counter);
+  rig.runner.run_for_ms(30000);
+  CHECK_EQ(rig.sim.refreshes().size(), 1u);
+  CHECK(!rig.panel.is_idle());
+
+  REQUIRE(rig.wait_idle());
+  REQUIRE(rig.sim.refreshes().size() == 2u);
+  // Refreshes start the same time after their update does.
+  const uint64_t gap = refresh_ms(rig, 1) - refresh_ms(rig, 0);
+  CHECK(gap >= MINUTE_MS);
+  CHECK(gap < MINUTE_MS + 1000u);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+}
+
+TEST_CASE(hourly_budget_is_a_sliding_window) {
+  Rig4P2In rig;
+  Counter counter;
+  rig.panel.set_max_refreshes_per_hour(3);
+  start(rig, counter);
+  // Two more, 20 minutes apart, use up the budget.
+  for (int i = 0; i < 2; i++) {
+    rig.runner.run_for_ms(20 * MINUTE_MS);
+    change(rig, counter);
+    REQUIRE(rig.wait_idle(MINUTE_MS));
+  }
+  REQUIRE(rig.sim.refreshes().size() == 3u);
+
+  // Waits for the first refresh to be an hour old, then the next for the second.
+  rig.runner.run_for_ms(10 * MINUTE_MS);
+  change(rig, counter);
+  rig.runner.run_for_ms(5 * MINUTE_MS);
+  CHECK_EQ(rig.sim.refreshes().size(), 3u);
+  REQUIRE(rig.wait_idle(60 * MINUTE_MS));
+  change(rig, counter);
+  REQUIRE(rig.wait_idle(60 * MINUTE_MS));
+  REQUIRE(rig.sim.refreshes().size() == 5u);
+  CHECK(refresh_ms(rig, 3) - refresh_ms(rig, 0) >= 60u * MINUTE_MS);
+  CHECK(refresh_ms(rig, 3) - refresh_ms(rig, 0) < 61u * MINUTE_MS);
+  CHECK(refresh_ms(rig, 4) - refresh_ms(rig, 1) >= 60u * MINUTE_MS);
+  CHECK(refresh_ms(rig, 4) - refresh_ms(rig, 1) < 61u * MINUTE_MS);
+}
+
+TEST_CASE(urgent_request_ignores_limits) {
+  Rig4P2In rig;
+  Counter counter;
+  rig.panel.set_min_update_interval(10 * MINUTE_MS);
+  rig.panel.set_max_refreshes_per_hour(1);
+  start(rig, counter);
+
+  for (int i = 0; i < 2; i++) {
+    const uint64_t requested = now_ms();
+    change(rig, counter, UpdatePriority::URGENT);
+    REQUIRE(rig.wait_idle(MINUTE_MS));
+    CHECK(now_ms() - requested < 10000u);
+  }
+  CHECK_EQ(rig.sim.refreshes().size(), 3u);
+
+  // A routine one after them still waits.
+  change(rig, counter);
+  rig.runner.run_for_ms(5 * MINUTE_MS);
+  CHECK_EQ(rig.sim.refreshes().size(), 3u);
+}
+
+TEST_CASE(pending_requests_merge) {
+  Rig4P2In rig;
+  Counter counter;
+  // Holds routine requests back, so the urgent one below has a deferred request to lift.
+  rig.panel.set_min_update_interval(MINUTE_MS);
+  start(rig, counter);
+
+  // Requests made before the panel takes up the pending one join it. The strongest mode wins,
+  // FULL > FAST > PARTIAL, and a request without a mode doesn't weaken it.
+  change(rig, counter);
+  rig.panel.request_update(UpdatePriority::ROUTINE, UpdateMode::FAST);
+  rig.panel.request_update(UpdatePriority::ROUTINE, UpdateMode::PARTIAL);
+  rig.panel.request_update(UpdatePriority::ROUTINE);
+  REQUIRE(rig.wait_idle());
+  REQUIRE(rig.sim.refreshes().size() == 2u);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xC7);
+
+  change(rig, counter);
+  rig.panel.request_update(UpdatePriority::ROUTINE, UpdateMode::FULL);
+  rig.panel.request_update(UpdatePriority::ROUTINE, UpdateMode::FAST);
+  REQUIRE(rig.wait_idle());
+  REQUIRE(rig.sim.refreshes().size() == 3u);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xF7);
+
+  change(rig, counter);
+  rig.panel.request_update(UpdatePriority::ROUTINE, UpdateMode::PARTIAL);
+  REQUIRE(rig.wait_idle());
+  REQUIRE(rig.sim.refreshes().size() == 4u);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xFF);
+
+  // An urgent request lifts a deferred routine one, and a routine one after it doesn't lower it.
+  change(rig, counter);
+  rig.runner.run_for_ms(5000);
+  CHECK_EQ(rig.sim.refreshes().size(), 4u);
+  const uint64_t requested = now_ms();
+  rig.panel.request_update(UpdatePriority::URGENT);
+  rig.panel.request_update(UpdatePriority::ROUTINE);
+  REQUIRE(rig.wait_idle());
+  CHECK(now_ms() - requested < 10000u);
+  CHECK_EQ(rig.sim.refreshes().size(), 5u);
+}
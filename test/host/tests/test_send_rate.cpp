@@ -0,0 +1,65 @@
+// The per-loop send budget: how many bytes one loop() call puts on the bus.
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using crowpanel_epaper::UpdateMode;
+
+namespace {
+
+const uint32_t SEND_BUDGET_US = 4000;
+
+uint32_t frame_number = 0;
+
+// Fills the frame, so every byte goes out.
+void draw_full(CrowPanelEPaper &it) {
+  for (int y = frame_number % 2; y < it.get_height(); y += 2)
+    it.horizontal_line(0, y, it.get_width());
+}
+
+// Changes one small block, so a partial update sends a window well below one budget's worth.
+void draw_block(CrowPanelEPaper &it) { it.filled_rectangle(40 + (frame_number % 2) * 8, 40, 64, 64); }
+
+}  // namespace
+
+TEST_CASE(dma_upload_stays_within_budget) {
+  // At 1 MHz the fake DMA takes 8 us per byte, much slower than queueing a transaction.
+  Rig4P2In rig;
+  rig.use_hardware_spi(1000000);
+  rig.panel.set_panel_writer(draw_full);
+  REQUIRE(rig.start());
+  for (int i = 0; i < 3; i++) {
+    frame_number++;
+    REQUIRE(rig.update());
+    CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+    CHECK(rig.panel.max_loop_us() <= SEND_BUDGET_US * 3 / 2);
+  }
+  // What the wire takes, not how fast transactions are queued.
+  CHECK(rig.panel.send_rate() > 0.12f && rig.panel.send_rate() < 0.13f);
+}
+
+TEST_CASE(rate_comes_down_when_wire_slows) {
+  Rig4P2In rig;
+  WireTransport transport(&rig.wire);
+  rig.use_transport(&transport);
+  rig.panel.set_panel_writer(draw_block);
+  REQUIRE(rig.start());
+  frame_number++;
+  REQUIRE(rig.update());
+  const float fast_rate = rig.panel.send_rate();
+  CHECK(fast_rate > 0.0f);
+
+  // 50x slower: the first window overruns the budget, later ones must not.
+  transport.set_ns_per_byte(20000);
+  rig.panel.set_update_mode(UpdateMode::PARTIAL);
+  for (int i = 0; i < 12; i++) {
+    frame_number++;
+    REQUIRE(rig.update());
+  }
+  CHECK(rig.panel.send_rate() < fast_rate / 10);
+  CHECK(rig.panel.max_loop_us() <= SEND_BUDGET_US * 3 / 2);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+}
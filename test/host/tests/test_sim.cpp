@@ -0,0 +1,207 @@
+// Drives the panel models through the bit-banged bus into the SSD1683 simulator and checks what
+// ends up in the controller RAM against the driver's own buffer.
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <string>
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+
+namespace {
+
+// A dashboard-like frame whose content moves with `step`.
+struct Scene {
+  int step{0};
+  void draw(CrowPanelEPaper &it) const {
+    it.filled_rectangle(10, 10, 120, 40);
+    it.rectangle(0, 0, it.get_width(), it.get_height());
+    it.line(0, it.get_height() - 1, it.get_width() - 1, 0);
+    it.filled_rectangle(150 + 7 * this->step, 100, 33, 21);
+  }
+};
+
+template<typename R> void check_clean(const R &rig) {
+  for (const auto &error : rig.sim.errors())
+    harness::fail(__FILE__, __LINE__, "sim: " + error);
+  for (const auto &error : rig.wire.errors())
+    harness::fail(__FILE__, __LINE__, "wire: " + error);
+  CHECK_EQ(rig.sim.bytes_while_busy(), 0u);
+}
+
+// The panel's bus counters cover exactly what the controller received during the update.
+template<typename R> void check_byte_counts(R &rig) {
+  CHECK_EQ(rig.sim.command_bytes(), rig.panel.bus_command_bytes());
+  CHECK_EQ(rig.sim.data_bytes(), rig.panel.bus_data_bytes());
+}
+
+template<typename R> uint32_t count_commands(const R &rig, uint8_t command, uint8_t target) {
+  uint32_t count = 0;
+  for (const auto &c : rig.sim.commands())
+    count += c.command == command && c.target == target;
+  return count;
+}
+
+}  // namespace
+
+TEST_CASE(full_update_4p2in_matches_buffer) {
+  Rig4P2In rig;
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  REQUIRE(rig.start());
+  rig.sim.reset_counters();
+  REQUIRE(rig.update());
+
+  REQUIRE(rig.sim.refreshes().size() == 1);
+  const auto &refresh = rig.sim.refreshes().back();
+  CHECK_EQ(refresh.sequence, 0xF7);
+  CHECK(refresh.new_image == rig.panel.transfer_frame());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  check_byte_counts(rig);
+  // The whole frame went over the bus at least once.
+  CHECK(rig.sim.data_bytes() >= rig.panel.buffer_length());
+  check_clean(rig);
+}
+
+TEST_CASE(partial_update_4p2in_sends_dirty_window) {
+  Rig4P2In rig;
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+
+  scene.step = 1;
+  rig.sim.reset_counters();
+  rig.sim.clear_commands();
+  REQUIRE(rig.update());
+
+  REQUIRE(rig.sim.refreshes().size() == 2);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xFF);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  // After the refresh the old image is brought in line for the next partial update.
+  CHECK(rig.sim.frame(Ram::OLD_IMAGE) == rig.sim.frame(Ram::NEW_IMAGE));
+  check_byte_counts(rig);
+  // Only the moved rectangle's bytes, not the frame.
+  CHECK(rig.sim.data_bytes() < rig.panel.buffer_length() / 4);
+  for (const auto &c : rig.sim.commands()) {
+    if (c.command == 0x45 && c.data.size() == 4) {
+      const uint16_t y_start = c.data[0] | c.data[1] << 8;
+      const uint16_t y_end = c.data[2] | c.data[3] << 8;
+      CHECK(y_start >= 100 && y_end < 121);
+    }
+  }
+  check_clean(rig);
+}
+
+TEST_CASE(cascade_5p79in_matches_buffer) {
+  Rig5P79In rig;
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) {
+    scene.draw(it);
+    // Across the column both controllers share.
+    it.filled_rectangle(380, 50, 40, 60);
+  });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+
+  REQUIRE(rig.sim.refreshes().size() == 1);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(rig.sim.shared_column_consistent(Ram::NEW_IMAGE));
+  CHECK(count_commands(rig, 0x24, 0) > 0);
+  CHECK(count_commands(rig, 0x24, 1) > 0);
+  CHECK(count_commands(rig, 0x44, 1) > 0);
+  check_clean(rig);
+}
+
+TEST_CASE(cascade_5p79in_partial_left_half_only) {
+  Rig5P79In rig;
+  int x = 20;
+  rig.panel.set_panel_writer([&x](CrowPanelEPaper &it) { it.filled_rectangle(x, 30, 16, 16); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+
+  x = 40;
+  rig.sim.clear_commands();
+  rig.sim.reset_counters();
+  REQUIRE(rig.update());
+
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xFF);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(rig.sim.frame(Ram::OLD_IMAGE) == rig.sim.frame(Ram::NEW_IMAGE));
+  CHECK(rig.sim.shared_column_consistent(Ram::OLD_IMAGE));
+  check_byte_counts(rig);
+  check_clean(rig);
+}
+
+TEST_CASE(split_layout_shows_same_frame) {
+  auto draw = [](CrowPanelEPaper &it) {
+    it.filled_rectangle(5, 5, 700, 30);
+    it.filled_rectangle(390, 40, 20, 200);
+    it.line(0, 0, it.get_width() - 1, it.get_height() - 1);
+  };
+  Rig5P79In plain;
+  plain.panel.set_panel_writer(draw);
+  REQUIRE(plain.start());
+  REQUIRE(plain.update());
+  const auto expected = plain.sim.frame(Ram::NEW_IMAGE);
+  check_clean(plain);
+
+  Rig5P79In split;
+  split.panel.set_split_layout(true);
+  split.panel.set_panel_writer(draw);
+  REQUIRE(split.start());
+  REQUIRE(split.update());
+  CHECK(split.sim.frame(Ram::NEW_IMAGE) == expected);
+  CHECK(split.sim.shared_column_consistent(Ram::NEW_IMAGE));
+  check_clean(split);
+}
+
+TEST_CASE(pbm_dumped_per_refresh) {
+  const std::string directory = "frames";
+  mkdir(directory.c_str(), 0755);
+  Rig4P2In rig;
+  rig.sim.set_dump_dir(directory, "test_sim");
+  Scene scene;
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  scene.step = 2;
+  REQUIRE(rig.update());
+
+  for (const char *name : {"test_sim_001_new.pbm", "test_sim_001_old.pbm", "test_sim_002_new.pbm"}) {
+    FILE *file = fopen((directory + "/" + name).c_str(), "rb");
+    REQUIRE(file != nullptr);
+    char header[16] = {};
+    CHECK(fgets(header, sizeof(header), file) != nullptr);
+    CHECK(std::string(header) == "P4\n");
+    fseek(file, 0, SEEK_END);
+    // Header lines plus 400x300 bits.
+    CHECK(ftell(file) > 50 * 300);
+    fclose(file);
+  }
+  check_clean(rig);
+}
+
+TEST_CASE(deep_sleep_keeps_ram) {
+  Rig4P2In rig;
+  Scene scene;
+  rig.panel.set_sleep_between_updates(true);
+  rig.panel.set_panel_writer([&scene](CrowPanelEPaper &it) { scene.draw(it); });
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK(rig.sim.asleep());
+  const uint32_t resets = rig.sim.hardware_resets();
+
+  scene.step = 3;
+  REQUIRE(rig.update());
+  CHECK(rig.sim.asleep());
+  CHECK_EQ(rig.sim.hardware_resets(), resets + 1);
+  CHECK_EQ(rig.sim.refreshes().back().sequence, 0xFF);
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  check_clean(rig);
+}
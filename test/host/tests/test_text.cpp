@@ -0,0 +1,113 @@
+// The blitting print() against font::Font::print() drawing pixel by pixel, which is what the
+// device does without it.
+
+#include <string>
+#include <vector>
+
+#include "font_loader.h"
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using display::TextAlign;
+
+namespace {
+
+const TextAlign ALIGNMENTS[] = {
+    TextAlign::TOP_LEFT,     TextAlign::TOP_CENTER,      TextAlign::TOP_RIGHT,
+    TextAlign::CENTER_LEFT,  TextAlign::CENTER,          TextAlign::CENTER_RIGHT,
+    TextAlign::BASELINE_LEFT, TextAlign::BASELINE_CENTER, TextAlign::BASELINE_RIGHT,
+    TextAlign::BOTTOM_LEFT,  TextAlign::BOTTOM_CENTER,   TextAlign::BOTTOM_RIGHT,
+};
+
+using Panel = TestPanel<crowpanel_epaper::CrowPanelEPaper4P2In>;
+
+// A pixel at rotation 0, where the native X runs mirrored. 0 bits are black.
+bool is_on(Panel &panel, int x, int y) {
+  const int native_x = panel.get_width() - 1 - x;
+  return !(panel.buffer()[y * (panel.get_width() / 8) + native_x / 8] & (0x80 >> (native_x % 8)));
+}
+
+std::vector<uint8_t> snapshot(Panel &panel) {
+  return std::vector<uint8_t>(panel.buffer(), panel.buffer() + panel.buffer_length());
+}
+
+// Draws `text` both ways at every rotation and alignment and compares the buffers.
+void check_matches_upstream(font::Font *font, const char *text, int x, int y) {
+  Rig4P2In rig;
+  REQUIRE(rig.start());
+  Panel &panel = rig.panel;
+  for (int r = 0; r < 4; r++) {
+    panel.set_rotation(static_cast<display::DisplayRotation>(r * 90));
+    for (TextAlign align : ALIGNMENTS) {
+      panel.fill(display::COLOR_OFF);
+      panel.print(x, y, font, display::COLOR_ON, align, text);
+      const auto fast = snapshot(panel);
+      panel.fill(display::COLOR_OFF);
+      panel.esphome::display::Display::print(x, y, font, display::COLOR_ON, align, text);
+      if (snapshot(panel) != fast) {
+        harness::fail(__FILE__, __LINE__,
+                      "\"" + std::string(text) + "\" at " + std::to_string(x) + "," + std::to_string(y) + " rotation " +
+                          std::to_string(r * 90) + " align " + std::to_string(static_cast<int>(align)));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE(print_matches_upstream) {
+  auto font = load_font(font_path("OpenSans-Medium.ttf"), 20, ascii_chars());
+  if (font == nullptr)
+    return;  // No FreeType
+  check_matches_upstream(font->get(), "Temperature 21.5 jy_Wf", 150, 120);
+  // Glyphs reaching past the left, top, right and bottom edges.
+  check_matches_upstream(font->get(), "jagged Wolf", 0, 0);
+  check_matches_upstream(font->get(), "jagged Wolf", 299, 399);
+}
+
+TEST_CASE(print_large_and_icons_match_upstream) {
+  auto large = load_font(font_path("OpenSans-Bold.ttf"), 64, ascii_chars());
+  auto icons = load_font(font_path("materialdesignicons-webfont.ttf"), 48, {"\U000F0599", "\U000F050F"});
+  if (large == nullptr || icons == nullptr)
+    return;
+  check_matches_upstream(large->get(), "12:34", 100, 100);
+  check_matches_upstream(icons->get(), "\U000F0599\U000F050F", 60, 200);
+}
+
+// Characters missing from the font get a placeholder one glyph advance wide.
+TEST_CASE(placeholder_matches_upstream) {
+  auto font = load_font(font_path("OpenSans-Medium.ttf"), 20, {"A", "b", "c"});
+  if (font == nullptr)
+    return;
+  // Both paths warn about every missing character.
+  host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+  check_matches_upstream(font->get(), "AxbZc", 100, 100);
+  host::set_log_level(ESPHOME_LOG_LEVEL_WARN);
+}
+
+// The cursor moves by the glyph advance, so text ends where get_text_bounds() says.
+TEST_CASE(print_width_matches_measure) {
+  auto font = load_font(font_path("OpenSans-Medium.ttf"), 20, ascii_chars());
+  if (font == nullptr)
+    return;
+  Rig4P2In rig;
+  REQUIRE(rig.start());
+  Panel &panel = rig.panel;
+  for (const char *text : {"iiii", "WWWW", "1.1 ff0", "Temperature"}) {
+    int x1, y1, width, height;
+    panel.get_text_bounds(300, 100, text, font->get(), TextAlign::TOP_RIGHT, &x1, &y1, &width, &height);
+    panel.fill(display::COLOR_OFF);
+    panel.print(300, 100, font->get(), display::COLOR_ON, TextAlign::TOP_RIGHT, text);
+    int rightmost = -1;
+    for (int y = 0; y < panel.get_height(); y++) {
+      for (int x = 0; x < panel.get_width(); x++) {
+        if (is_on(panel, x, y) && x > rightmost)
+          rightmost = x;
+      }
+    }
+    CHECK(rightmost < 300);
+    CHECK(rightmost >= 300 - 3);
+  }
+}
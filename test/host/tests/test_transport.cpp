@@ -0,0 +1,122 @@
+// Transport setup failures and the ESP32 SPI master path, on the fake ESP-IDF driver.
+
+#include "harness.h"
+#include "rig.h"
+
+using namespace esphome;
+using namespace esphome::sim;
+using crowpanel_epaper::CrowPanelEPaper;
+using host::idf::Call;
+
+namespace {
+
+void draw(CrowPanelEPaper &it) {
+  it.filled_rectangle(20, 20, 200, 100);
+  it.line(0, 0, it.get_width() - 1, it.get_height() - 1);
+}
+
+template<typename R> void check_clean(const R &rig) {
+  for (const auto &error : rig.sim.errors())
+    harness::fail(__FILE__, __LINE__, "sim: " + error);
+  for (const auto &error : rig.wire.errors())
+    harness::fail(__FILE__, __LINE__, "wire: " + error);
+}
+
+template<typename R> void check_failed(R &rig) {
+  rig.runner.setup();
+  rig.runner.run_for_ms(1000);
+  CHECK(rig.panel.is_failed());
+  CHECK_EQ(rig.runner.loop_calls(&rig.panel), 0u);
+  CHECK_EQ(rig.wire.byte_count(), 0u);
+  CHECK(host::error_count() > 0);
+}
+
+}  // namespace
+
+TEST_CASE(transport_setup_failure_marks_failed) {
+  Rig4P2In rig;
+  WireTransport transport(&rig.wire);
+  transport.fail_setup = true;
+  rig.use_transport(&transport);
+  check_failed(rig);
+  CHECK_EQ(transport.setup_calls, 1u);
+}
+
+TEST_CASE(wire_transport_matches_buffer) {
+  Rig4P2In rig;
+  WireTransport transport(&rig.wire);
+  rig.use_transport(&transport);
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(transport.array_writes > 0);
+  CHECK(transport.flushes > 0);
+  check_clean(rig);
+}
+
+TEST_CASE(hardware_spi_matches_buffer) {
+  Rig5P79In rig;
+  rig.use_hardware_spi();
+  rig.panel.set_panel_writer(draw);
+  REQUIRE(rig.start());
+  rig.sim.reset_counters();
+  REQUIRE(rig.update());
+  CHECK(!rig.panel.is_failed());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  CHECK(host::idf::queued_transactions() > 0);
+  CHECK_EQ(rig.sim.command_bytes(), rig.panel.bus_command_bytes());
+  CHECK_EQ(rig.sim.data_bytes(), rig.panel.bus_data_bytes());
+  check_clean(rig);
+}
+
+TEST_CASE(hardware_spi_bus_initialize_failure) {
+  Rig4P2In rig;
+  rig.use_hardware_spi();
+  host::idf::fail_next(Call::BUS_INITIALIZE);
+  check_failed(rig);
+}
+
+TEST_CASE(hardware_spi_add_device_failure_frees_bus) {
+  Rig4P2In rig;
+  rig.use_hardware_spi();
+  host::idf::fail_next(Call::ADD_DEVICE);
+  check_failed(rig);
+  CHECK(!host::idf::bus_initialized(SPI2_HOST));
+}
+
+TEST_CASE(hardware_spi_without_dma_buffers_polls) {
+  Rig4P2In rig;
+  rig.use_hardware_spi();
+  rig.panel.set_panel_writer(draw);
+  host::idf::fail_next(Call::DMA_MALLOC);
+  REQUIRE(rig.start());
+  REQUIRE(rig.update());
+  CHECK(!rig.panel.is_failed());
+  CHECK(host::warning_count() > 0);
+  CHECK_EQ(host::idf::dma_buffers(), 0u);
+  CHECK_EQ(host::idf::queued_transactions(), 0u);
+  CHECK(host::idf::polled_transactions() > rig.panel.buffer_length());
+  CHECK(rig.sim.frame(Ram::NEW_IMAGE) == rig.panel.transfer_frame());
+  check_clean(rig);
+}
+
+// SPI2 can only be initialized once; display.py rejects a second hardware transport for that.
+TEST_CASE(second_hardware_transport_fails) {
+  MockPin clk{12, "clk"}, mosi{11, "mosi"};
+  crowpanel_epaper::ESP32SPITransport first(&clk, &mosi, 20000000);
+  crowpanel_epaper::ESP32SPITransport second(&clk, &mosi, 20000000);
+  CHECK(first.setup());
+  CHECK(!second.setup());
+}
+
+TEST_CASE(failed_bus_fails_its_panels) {
+  Rig4P2In rig;
+  WireTransport transport(&rig.wire);
+  transport.fail_setup = true;
+  crowpanel_epaper::CrowPanelBus bus(&transport);
+  rig.panel.set_bus(&bus);
+  rig.runner.add(&bus);
+  check_failed(rig);
+  CHECK(bus.is_failed());
+}